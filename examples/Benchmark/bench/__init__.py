@@ -0,0 +1 @@
+from .scenes import SCENES, BenchScene
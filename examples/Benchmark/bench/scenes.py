@@ -0,0 +1,233 @@
+import json
+import math
+import random
+
+import carrotlib as cl
+import raylib as rl
+from linalg import vec2, mat3x3
+
+from carrotlib.ldtk import Project
+from carrotlib.ldtk.layer import AutoTiledLayer
+
+# every scene seeds `random` on creation, so two runs build the same scene
+SEED = 0
+
+
+class BenchScene(cl.Node):
+    def __init__(self, name=None, parent=None):
+        random.seed(SEED)
+        super().__init__(name, parent)
+        cl.set_camera_transform(mat3x3.identity())
+
+
+class SpriteScene(BenchScene):
+    """10k sprites in 10 spinning groups, so every world transform is dirty each frame."""
+    COUNT = 10000
+    GROUPS = 10
+
+    def __init__(self, name=None, parent=None):
+        super().__init__(name, parent)
+        square = cl.load_square_texture(8)
+        tileset = cl.load_texture('assets/tileset.png')
+        self.groups = []
+        for i in range(self.GROUPS):
+            group = cl.Node(f'group_{i}', parent=self)
+            self.groups.append(group)
+        for i in range(self.COUNT):
+            sprite = cl.nodes.Sprite(parent=self.groups[i % self.GROUPS])
+            # interleave two textures, like a real scene does
+            if i % 2 == 0:
+                sprite.texture = square
+                sprite.color = cl.Color(random.randint(64, 255), random.randint(64, 255), random.randint(64, 255), 255)
+            else:
+                tid = random.randint(0, 15)
+                sprite.texture = cl.SubTexture2D(tileset, tid % 4 * 16, tid // 4 * 16, 16, 16)
+            sprite.position = vec2(random.random() * 120 - 60, random.random() * 64 - 32)
+            sprite.rotation = random.random() * 6.28
+
+    def on_update(self):
+        dt = rl.GetFrameTime()
+        for i, group in enumerate(self.groups):
+            group.rotation += dt * (0.05 + 0.01 * i)
+
+
+class _Ball(cl.Node):
+    def __init__(self, scene: 'PhysicsScene', position: vec2, radius: float):
+        super().__init__(parent=scene)
+        self.scene = scene
+        self.radius = radius
+        self.position = position
+        self.b2_body = self.create_body()
+        self.b2_body.set_circle_shape(radius)
+        self.b2_body.position = position
+        self.b2_body.restitution = 0.2
+
+    def on_box2d_contact_begin(self, other):
+        self.scene.contacts += 1
+
+    def on_box2d_post_step(self):
+        self.position = self.b2_body.position
+
+    def on_render(self):
+        cl.draw_circle(self.b2_body.interpolated_position, self.radius, cl.Colors.SkyBlue)
+
+
+class PhysicsScene(BenchScene):
+    """5k dynamic circles falling into a box, with contact callbacks."""
+    COUNT = 5000
+
+    def __init__(self, name=None, parent=None):
+        super().__init__(name, parent)
+        self.contacts = 0
+        cl.g.b2_world.gravity = vec2(0, 30)
+
+        # static walls around the viewport
+        for x, y, hx, hy in [(0, 35, 64, 1), (-63, 0, 1, 36), (63, 0, 1, 36)]:
+            wall = self.create_body()
+            wall.type = 0
+            wall.set_box_shape(hx, hy)
+            wall.position = vec2(x, y)
+
+        cols = 100
+        for i in range(self.COUNT):
+            x = (i % cols - cols / 2) * 1.2 + random.random() * 0.2
+            y = 30 - (i // cols) * 1.2
+            _Ball(self, vec2(x, y), 0.45)
+
+    def on_destroy(self):
+        cl.g.b2_world.gravity = vec2(0, 0)
+
+
+class ParticleScene(BenchScene):
+    """50 emitters, each saturated at 1000 live particles."""
+    COUNT = 50
+
+    def __init__(self, name=None, parent=None):
+        super().__init__(name, parent)
+        texture = cl.load_square_texture(4)
+        for i in range(self.COUNT):
+            emitter = cl.nodes.particles.Particles(parent=self)
+            emitter.position = vec2((i % 10 - 4.5) * 12, (i // 10 - 2) * 12)
+            emitter.max_particles = 1000
+            emitter.rate_over_time = 400
+            emitter.start_lifetime = (2.5, 3.0)
+            emitter.start_speed = (2.0, 6.0)
+            emitter.start_texture = texture
+            emitter.start_color = (cl.Color(255, 160, 40, 255), cl.Color(255, 255, 160, 255))
+            emitter.shape = cl.nodes.particles.CircleEmissionShape(1.0)
+
+
+def _rule(uid: int, size: int, pattern: list[int], tiles: list[int], chance=1.0) -> dict:
+    return {
+        'uid': uid, 'active': True, 'size': size, 'pattern': pattern,
+        'tileRectsIds': [[t] for t in tiles], 'chance': chance, 'breakOnMatch': True,
+        'alpha': 1, 'outOfBoundsValue': None, 'flipX': False, 'flipY': False,
+        'tileMode': 'Single', 'pivotX': 0, 'pivotY': 0,
+        'xModulo': 1, 'yModulo': 1, 'xOffset': 0, 'yOffset': 0, 'checker': 'None',
+        'tileXOffset': 0, 'tileYOffset': 0,
+        'tileRandomXMin': 0, 'tileRandomXMax': 0, 'tileRandomYMin': 0, 'tileRandomYMax': 0,
+        'invalidated': False,
+        'perlinActive': False, 'perlinSeed': 0, 'perlinScale': 0.2, 'perlinOctaves': 2,
+    }
+
+
+def build_terrain_layer(width: int, height: int, grid_size=16) -> AutoTiledLayer:
+    """A generated LDtk project with an IntGrid terrain and an auto-layer on top of it."""
+    heights = []
+    h = height // 3
+    for x in range(width):
+        h = min(max(h + random.randint(-1, 1), 8), height - 8)
+        heights.append(h)
+    csv = []
+    for y in range(height):
+        for x in range(width):
+            solid = y >= heights[x] and random.random() > 0.05
+            csv.append(1 if solid else 0)
+
+    rules = [
+        # grass on top of the ground
+        _rule(1, 3, [0, -1, 0, 0, 1, 0, 0, 0, 0], [0, 1, 2, 3]),
+        # dirt inside
+        _rule(2, 1, [1], [4, 5, 6, 7]),
+        # sparse decorations in the air
+        _rule(3, 3, [0, 0, 0, 0, -1, 0, 0, 1, 0], [12, 13], chance=0.3),
+    ]
+    data = {
+        'jsonVersion': '1.5.3',
+        'defs': {
+            'layers': [
+                {'uid': 11, 'autoSourceLayerDefUid': 10, 'autoRuleGroups': [{'active': True, 'rules': rules}]},
+            ],
+            'tilesets': [
+                {'uid': 20, 'padding': 0, 'spacing': 0, 'tileGridSize': grid_size, 'relPath': 'tileset.png', '__cWid': 4, '__cHei': 4},
+            ],
+        },
+    }
+    level = {
+        'layerInstances': [
+            {'__type': 'IntGrid', 'layerDefUid': 10, 'seed': 0, 'intGridCsv': csv},
+            {'__type': 'AutoLayer', 'layerDefUid': 11, 'seed': 1234,
+             '__cWid': width, '__cHei': height, '__gridSize': grid_size,
+             '__tilesetDefUid': 20, '__pxTotalOffsetY': 0},
+        ]
+    }
+    return AutoTiledLayer(level, 1, Project(json.dumps(data)))
+
+
+class TilemapScene(BenchScene):
+    """A 256x256 auto-tiled map, the camera pans across it."""
+    SIZE = 256
+
+    def __init__(self, name=None, parent=None):
+        super().__init__(name, parent)
+        layer = build_terrain_layer(self.SIZE, self.SIZE)
+        self.tilemap = cl.nodes.Tilemap(layer, parent=self)
+        self.extent = self.SIZE * self.tilemap.cell_size
+
+    def on_update(self):
+        t = self.time()
+        center = vec2(0.5 + 0.35 * math.cos(t * 0.2), 0.5 + 0.35 * math.sin(t * 0.3)) * self.extent
+        cl.set_camera_transform(mat3x3.trs(center, 0, vec2(1, 1)))
+
+
+class _MovingLight(cl.PointLight2D):
+    def __init__(self, parent: cl.Node):
+        super().__init__(parent=parent)
+        self.color = cl.Color(random.randint(64, 255), random.randint(64, 255), random.randint(64, 255), 255)
+        self.radius = random.randint(24, 64)
+        self.intensity = 0.5 + random.random() * 0.5
+        self.center = vec2(random.random() * 120 - 60, random.random() * 64 - 32)
+        self.orbit = 2 + random.random() * 8
+        self.phase = random.random() * 6.28
+
+    def on_update(self):
+        t = self.time() + self.phase
+        self.position = self.center + vec2(math.cos(t), math.sin(t)) * self.orbit
+
+
+class LightScene(BenchScene):
+    """A viewport-sized lightmap lit by 200 moving point lights."""
+    COUNT = 200
+
+    def __init__(self, name=None, parent=None):
+        super().__init__(name, parent)
+        cl.g.default_lightmap = cl.Lightmap(cl.g.viewport_width, cl.g.viewport_height)
+        self.background = cl.nodes.Sprite(parent=self)
+        self.background.texture = cl.load_square_texture(16)
+        self.background.scale = vec2(cl.g.viewport_width, cl.g.viewport_height) / 16
+        self.background.material = cl.DiffuseMaterial()
+        for _ in range(self.COUNT):
+            _MovingLight(self)
+
+    def on_destroy(self):
+        cl.g.default_lightmap.destroy()
+        cl.g.default_lightmap = None
+
+
+SCENES = {
+    'sprites': SpriteScene,
+    'physics': PhysicsScene,
+    'particles': ParticleScene,
+    'tilemap': TilemapScene,
+    'lights': LightScene,
+}
@@ -0,0 +1,35 @@
+import sys
+import carrotlib as cl
+import raylib as rl
+
+from bench import SCENES, BenchScene
+
+# `GameBench . <template> [frames] [warmup] [dt] [output.json|-] [scene]` runs a single scene,
+# Game.exe starts with the first one, press 1-5 to switch
+SCENE_NAMES = list(SCENES.keys())
+
+
+class Benchmark(cl.Game):
+    def on_ready(self):
+        super().on_ready()
+        cl.g.background = cl.Color(24, 24, 32, 255)
+        argv = getattr(sys, 'argv', [])
+        name = argv[1] if len(argv) > 1 else SCENE_NAMES[0]
+        if name not in SCENES:
+            raise ValueError(f'unknown scene {name!r}, expected one of {SCENE_NAMES}')
+        self.scene: BenchScene = SCENES[name](name)
+
+    def on_update(self):
+        for i, name in enumerate(SCENE_NAMES):
+            if rl.IsKeyPressed(rl.KEY_ONE + i) and name != self.scene.name:
+                self.scene.destroy()
+                self.scene = SCENES[name](name)
+        super().on_update()
+
+    @property
+    def design_size(self):
+        return (1280, 720)
+
+    @property
+    def title(self):
+        return 'Benchmark'
@@ -34,7 +34,7 @@ class ArrowDestroyFX(cl.nodes.Sprite):
 class Arrow(cl.nodes.Sprite):
     def __init__(self, name=None):
         super().__init__(name=name, parent=None)
-        self.texture = cl.load_texture('assets/sprites/demo/arrow/idle/1.png')
+        self.texture = cl.load_atlas_texture('assets/sprites/demo/arrow/idle/1.png')
         self.b2_body = self.create_body()
 
         radius = self.texture.height / 2 / cl.g.PIXEL_PER_UNIT * 0.8
@@ -63,8 +63,8 @@ class HeroBow(cl.nodes.Sprite):
     parent: 'Hero'
     def __init__(self, name=None, parent=None):
         super().__init__(name=name, parent=parent)
-        self.normal_tex = cl.load_texture('assets/sprites/demo/bow_1.png')
-        self.charge_tex = cl.load_texture('assets/sprites/demo/bow_2.png')
+        self.normal_tex = cl.load_atlas_texture('assets/sprites/demo/bow_1.png')
+        self.charge_tex = cl.load_atlas_texture('assets/sprites/demo/bow_2.png')
         self.origin.y = 0.52
         self.position.y = 0.7
 
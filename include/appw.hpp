@@ -15,6 +15,21 @@ namespace ct{
 
     void patch_module_ct(VM* vm, PyVar mod);
 
+    // check if `type` overrides `base`'s method `name`
+    bool is_overridden(VM* vm, Type type, Type base, StrName name);
+
+    // `is_overridden()` for the items of one loop, resolved again only when the type changes
+    // an instance attribute `name` counts as an override, nothing is kept across loops
+    struct OverrideFilter{
+        Type base;
+        StrName name;
+        Type last_type = -1;
+        bool last_result = false;
+
+        OverrideFilter(Type base, StrName name) : base(base), name(name) {}
+        bool operator()(VM* vm, PyVar obj);
+    };
+
     // platform interfaces
     void platform_init();
     void platform_log_info(const Str& text);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "raylib.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    struct AtlasPacker;     // skyline packer of one page, see atlas.cpp
+
+    struct AtlasPage{
+        Image image;                // RGBA8, kept on the CPU while the page is packable or not uploaded
+        Texture2D texture;          // zero if the atlas has no GPU pages
+        AtlasPacker* packer;        // nullptr for pages packed ahead of time
+    };
+
+    struct AtlasEntry{
+        int page;
+        Rectangle rect;             // in texels of the page
+    };
+
+    // packs images into square pages, so sprites of different files share textures and draw calls
+    // pages are created on demand and uploaded incrementally with `UpdateTextureRec()`
+    struct TextureAtlas{
+        PK_ALWAYS_PASS_BY_POINTER(TextureAtlas)
+
+        int page_size;              // in texels
+        int padding;                // transparent border around every image
+        bool gpu;                   // false for offline packing, no texture is created
+        std::vector<AtlasPage> pages;
+        std::map<std::string, AtlasEntry, std::less<>> entries;
+
+        TextureAtlas(int page_size, int padding, bool gpu): page_size(page_size), padding(padding), gpu(gpu) {}
+        ~TextureAtlas();
+
+        // returns the existing entry if `name` was added before
+        // returns nullptr if the image is larger than a page
+        const AtlasEntry* add(std::string_view name, Image image);
+        const AtlasEntry* find(std::string_view name) const;
+        // adds a page packed ahead of time, its entries are set with `set_entry()`
+        int add_page(Image image);
+        void set_entry(std::string_view name, int page, Rectangle rect);
+        int page_count() const { return (int)pages.size(); }
+
+        // writes every page to `{prefix}{index}.png`
+        bool export_pages(std::string_view prefix) const;
+        // frees the pages, textures included
+        void unload();
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+    };
+}
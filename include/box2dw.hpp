@@ -62,6 +62,8 @@ struct PyContactListener: b2ContactListener{
     }
 };
 
+struct PyWorld;
+
 struct PyBody{
     PK_ALWAYS_PASS_BY_POINTER(PyBody)
 
@@ -70,8 +72,13 @@ struct PyBody{
     PyVar node_like;
     bool with_callback;
 
+    // transform before the last fixed step, for render interpolation
+    PyWorld* _world;
+    b2Vec2 _prev_position;
+    float _prev_rotation;
+
     bool _is_destroyed;
-    PyBody(): body(nullptr), _fixture(nullptr), node_like(nullptr), _is_destroyed(false){}
+    PyBody(): body(nullptr), _fixture(nullptr), node_like(nullptr), _world(nullptr), _prev_rotation(0), _is_destroyed(false){}
 
     void _gc_mark(VM* vm) {
         if(node_like != nullptr){
@@ -97,9 +104,12 @@ struct PyBody{
 
     // methods
     b2Vec2 get_position() const { return body->GetPosition(); }
-    void set_position(b2Vec2 v){ body->SetTransform(v, body->GetAngle()); }
+    // teleporting a body also resets its interpolation
+    void set_position(b2Vec2 v){ body->SetTransform(v, body->GetAngle()); _prev_position = v; }
     float get_rotation() const { return body->GetAngle(); }
-    void set_rotation(float v){ body->SetTransform(body->GetPosition(), v); }
+    void set_rotation(float v){ body->SetTransform(body->GetPosition(), v); _prev_rotation = v; }
+    b2Vec2 get_interpolated_position() const;
+    float get_interpolated_rotation() const;
     b2Vec2 get_velocity() const { return body->GetLinearVelocity(); }
     void set_velocity(b2Vec2 v){ body->SetLinearVelocity(v); }
 
@@ -124,8 +134,17 @@ struct PyWorld {
     PyContactListener _contact_listener;
     PyDebugDraw _debug_draw;
 
+    // fixed-step mode, disabled if `fixed_dt` is 0
+    float fixed_dt;
+    int max_substeps;
+    float accumulator;
+    float alpha;        // interpolation factor between the previous and current step
+
     PyWorld(VM* vm);
 
+    // step the world once and call pre/post step callbacks
+    void _substep(VM* vm, float dt, int velocity_iterations, int position_iterations);
+
     void _gc_mark(VM* vm){
         PK_OBJ_MARK(_debug_draw.draw_like);
     }
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "raylib.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace pkpy;
+
+struct stbtt_fontinfo;
+
+namespace ct{
+    struct GlyphSlot{
+        int codepoint;              // -1 if the slot is free
+        int last_used;              // `DynamicFont::tick` of the last `prepare()` that used it
+        bool pinned;                // printable ASCII and '?' are never evicted
+    };
+
+    // a rasterized glyph, as stored in the glyph cache on disk
+    struct GlyphImage{
+        int width, height;
+        int offset_x, offset_y;     // of the top-left corner, relative to the pen position on the baseline
+        int advance;
+        std::vector<unsigned char> alpha;   // coverage, or the distance to the edge for SDF fonts
+    };
+
+    // a raylib `Font` whose glyphs are rasterized the first time they are needed
+    // the texture is a grid of equal cells, one glyph per cell, the least recently used glyph
+    // is evicted when the grid is full
+    //
+    // `font` is allocated for every cell up front and never reallocated,
+    // so copies of it held by python stay valid and work with all raylib text functions
+    //
+    // SDF fonts store the distance to the glyph edge instead of the coverage, 0.5 on the edge,
+    // they are rasterized once at a small size and drawn at any size with the SDF text shader
+    // their glyphs are kept in a cache file, so they are not generated again on the next run
+    struct DynamicFont{
+        PK_ALWAYS_PASS_BY_POINTER(DynamicFont)
+
+        Font font;
+        unsigned char* ttf_data;
+        stbtt_fontinfo* info;
+        float scale;                // font units -> pixels
+        int ascent;                 // in pixels
+        int cell_size;              // in texels, padding included
+        int cells_per_row;
+
+        std::vector<GlyphSlot> slots;
+        std::unordered_map<int, int> slot_of;       // codepoint -> index into `slots` and `font.glyphs`
+        std::vector<int> free_slots;
+        int tick;
+        int generation;             // bumped on eviction, texture coordinates of evicted glyphs are reused
+        int evictions;
+
+        bool sdf;
+        int ttf_size;               // the cache file is ignored if the font file changed
+        std::string cache_path;     // empty if glyphs are not cached
+        std::unordered_map<int, GlyphImage> cached_glyphs;
+        bool cache_dirty;
+
+        DynamicFont(): font{}, ttf_data(nullptr), info(nullptr), scale(0), ascent(0), cell_size(0), cells_per_row(0),
+            tick(0), generation(0), evictions(0), sdf(false), ttf_size(0), cache_dirty(false) {}
+        ~DynamicFont();
+
+        // `texture_size` bounds the memory, 2 bytes per texel
+        bool load(const char* path, int font_size, int texture_size, bool sdf);
+        // rasterize the glyphs of `text` that are not in the texture yet and mark all of them as used
+        void prepare(std::string_view text);
+        int glyph_count() const { return (int)(slots.size() - free_slots.size()); }
+        Font get_font() const { return font; }
+        // half width of the anti-aliased edge for the SDF text shader, in distance units
+        float sdf_smoothing(float font_size) const;
+        // writes the glyphs generated since the cache file was loaded
+        bool save_cache();
+        // the cache is saved first
+        void unload();
+
+        // the dynamic font that owns `font`'s texture, or nullptr
+        static DynamicFont* find(const Font& font);
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+
+    private:
+        int _take_slot();
+        void _rasterize(int codepoint, bool pinned);
+        const GlyphImage& _glyph_image(int codepoint, GlyphImage& tmp);
+        void _load_cache();
+    };
+}
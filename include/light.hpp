@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <stdexcept>
+#include <vector>
 
 #include "raylib.h"
 
@@ -27,6 +28,85 @@ namespace ct{
         }
     };
 
+    // per-row kernels of the light baking, selected for the cpu at runtime
+    // `color` is (r, g, b, a) with the intensity applied and `a` clamped to [0, 1]
+    struct LightKernels{
+        const char* name;           // "avx2", "sse2", "neon" or "scalar"
+        // dst[i].rgb += color.rgb * max(base[i] - offset, 0), dst[i].a = color.a
+        void (*accumulate_row)(HdrColor* dst, const float* base, float offset, int n, const float color[4]);
+        // dst[i].rgb += color.rgb, dst[i].a = color.a
+        void (*add_constant)(HdrColor* dst, int n, const float color[4]);
+    };
+
+    const LightKernels& get_light_kernels();
+
+    // the light rectangle is clipped up front and texels are processed by `get_light_kernels()`
+    // the result matches `reference::` up to float rounding
     void bake_global_light(Image* img, Color color, double intensity);
     void bake_point_light(Image* img, Color color, double intensity, int x, int y, int r, Image* cookie);
+
+    // texels of a lightmap image, rows are counted after the vertical flip
+    struct LightRect{
+        int x, y, width, height;
+
+        bool empty() const { return width <= 0 || height <= 0; }
+        LightRect intersect(const LightRect& other) const{
+            int x0 = std::max(x, other.x), y0 = std::max(y, other.y);
+            int x1 = std::min(x + width, other.x + other.width), y1 = std::min(y + height, other.y + other.height);
+            return LightRect{x0, y0, x1 - x0, y1 - y0};
+        }
+        // the bounding box of both, empty rectangles are ignored
+        LightRect merge(const LightRect& other) const{
+            if(other.empty()) return *this;
+            if(empty()) return other;
+            int x0 = std::min(x, other.x), y0 = std::min(y, other.y);
+            int x1 = std::max(x + width, other.x + other.width), y1 = std::max(y + height, other.y + other.height);
+            return LightRect{x0, y0, x1 - x0, y1 - y0};
+        }
+    };
+
+    // a light of `bake_lights()`, in image coordinates before the vertical flip
+    struct LightBakeItem{
+        float color[4];             // see `LightKernels`
+        bool is_global;
+        int x, y, r;
+        Image* cookie;              // nullptr or a grayscale image
+        unsigned int cookie_texture;    // for `render_lights()`, 0 for the quadratic falloff
+
+        static LightBakeItem global(Color color, double intensity);
+        static LightBakeItem point(Color color, double intensity, int x, int y, int r, Image* cookie);
+
+        // the texels of `img` it lights, clipped to the image
+        LightRect rect(const Image* img) const;
+        bool operator==(const LightBakeItem& other) const;
+        bool operator!=(const LightBakeItem& other) const { return !(*this == other); }
+    };
+
+    // clears `img` to opaque black and bakes `lights` in order
+    // the rows are split into bands that are baked on the thread pool, each texel gets the same
+    // operations in the same order as a single-threaded bake, so the result is bit-identical
+    void bake_lights(Image* img, const std::vector<LightBakeItem>& lights);
+    // same as above for the texels of `region` only, the rest of the image is left as is
+    void bake_lights(Image* img, const std::vector<LightBakeItem>& lights, LightRect region);
+
+    // RGBM encoding of a float lightmap for RGBA8 textures, rgb * a * range is the light
+    // alpha is not stored, lights brighter than `range` saturate
+    void encode_rgbm(const HdrColor* src, int n, Color* dst, float range);
+
+    // grayscale image of the quadratic falloff of point lights over the light's square
+    Image gen_light_falloff(int size);
+
+    // GPU backend of the lightmap, lights are drawn as additive quads into a render texture
+    // the texture is floating point where the GPU can render to it, otherwise RGBA8 and lights saturate at 1.0
+    RenderTexture2D load_light_target(int width, int height);
+    // same as `bake_lights()` up to texture filtering, `falloff` is a texture of `gen_light_falloff()`
+    void render_lights(RenderTexture2D target, Texture2D falloff, const std::vector<LightBakeItem>& lights);
+
+    namespace reference{
+        // the original per-texel implementation, kept to check the kernels against
+        void bake_global_light(Image* img, Color color, double intensity);
+        void bake_point_light(Image* img, Color color, double intensity, int x, int y, int r, Image* cookie);
+        // bakes global, clipped and cookie lights both ways, returns the max difference of any channel
+        float check_kernels();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "raylib.h"
+#include "light.hpp"
+
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    // the state of a `Lightmap` between frames
+    // lights are compared with the ones of the previous update, texels that no changed light
+    // covers keep their value, so a lightmap of static lights costs nothing to update
+    struct LightmapBaker{
+        PK_ALWAYS_PASS_BY_POINTER(LightmapBaker)
+
+        std::vector<LightBakeItem> previous;
+        int width, height;          // of the image or target of the previous update, 0 before the first one
+        int dirty_texels;           // baked by the last update
+        float rgbm_range;           // 0 if the texture has the format of the image, otherwise RGBA8, see `encode_rgbm()`
+
+        LightmapBaker(float rgbm_range): width(0), height(0), dirty_texels(0), rgbm_range(rgbm_range) {}
+
+        // bakes the texels of `img` that changed and uploads them to `texture`
+        // returns false if nothing changed
+        bool bake(Image* img, Texture2D texture, std::vector<LightBakeItem>&& lights);
+        // redraws `target` if any light changed, see `render_lights()`
+        bool render(RenderTexture2D target, Texture2D falloff, std::vector<LightBakeItem>&& lights);
+        // the next update bakes or draws everything
+        void invalidate(){ width = 0; height = 0; }
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+
+    private:
+        LightRect _dirty_rect(const Image* img, const std::vector<LightBakeItem>& lights) const;
+    };
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "pocketpy.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    struct ProfilerPhase{
+        std::string name;
+        int depth;                  // nesting depth when first seen, 0 for top-level phases
+        std::vector<float> samples; // ring buffer of per-frame milliseconds
+        double current;             // accumulated milliseconds of the current frame
+        double total;               // milliseconds of all committed frames
+    };
+
+    // a chrome trace "complete" event, times are in nanoseconds since the capture started
+    struct TraceEvent{
+        int name;
+        i64 ts;
+        i64 dur;
+    };
+
+    struct Profiler{
+        PK_ALWAYS_PASS_BY_POINTER(Profiler)
+
+        using clock = std::chrono::steady_clock;
+
+        struct OpenScope{
+            int phase;              // -1 for trace-only scopes
+            int trace_name;         // -1 if the scope started before the capture
+            clock::time_point start;
+        };
+
+        int capacity;                       // number of frames kept
+        int cursor;                         // next frame to write
+        int count;                          // number of recorded frames, up to `capacity`
+        std::vector<ProfilerPhase> phases;
+        std::unordered_map<std::string, int> phase_ids;
+        std::vector<OpenScope> stack;
+        std::vector<float> frame_samples;   // wall time between `new_frame()` calls
+        clock::time_point frame_start;
+        bool started;
+
+        // trace capture, events go into a fixed-size arena allocated when the capture starts
+        std::vector<TraceEvent> trace_events;
+        int trace_size;
+        int trace_dropped;
+        int trace_pending;              // frames to capture from the next `new_frame()`
+        int trace_frames_left;
+        bool tracing;
+        clock::time_point trace_origin;
+        std::vector<std::string> trace_names;
+        std::unordered_map<std::string, int> trace_name_ids;
+        std::map<i64, int> trace_key_names;     // caller-defined key -> trace name
+        std::vector<int> phase_trace_names;     // phase -> trace name
+        std::string last_trace_path;
+
+        // the profiler of the running VM, used by native scopes
+        static Profiler* current;
+        // unique per profiler ever created, a new profiler may reuse the address of a freed one
+        int serial;
+        static int next_serial;
+
+        Profiler(int capacity);
+        ~Profiler();
+
+        int phase_id(std::string_view name);
+        void begin(int phase);
+        void end();
+        // end phases left open, commit the current frame into the ring buffers and start a new one
+        void new_frame();
+
+        // sample of `phase` (or of the whole frame if `phase` is -1), `age` 0 is the latest frame
+        float sample(int phase, int age) const;
+        void percentiles(int phase, float out[3]) const;
+        void render_graph(float height) const;
+
+        // capture `frames` whole frames, starting from the next `new_frame()`
+        void start_trace(int frames, int max_events);
+        int trace_name_id(std::string_view name);
+        // intern a trace name under a caller-defined key, `make_name()` is only called once per key
+        template<typename F>
+        int trace_key(i64 key, F&& make_name){
+            auto it = trace_key_names.find(key);
+            if(it != trace_key_names.end()) return it->second;
+            int id = trace_name_id(make_name());
+            trace_key_names[key] = id;
+            return id;
+        }
+        // a scope that only shows up in traces, not in the phase ring buffers
+        void trace_begin(int trace_name);
+        void _emit(int trace_name, clock::time_point start, clock::time_point end);
+        void _flush_trace();
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+    };
+
+    // write `s` as a quoted JSON string, control characters are dropped
+    void write_json_string(FILE* fp, std::string_view s);
+
+    // the phase of a `CT_PROFILE_SCOPE()` call site, looked up again only when the profiler changes
+    struct ProfileSite{
+        const char* name;
+        int serial;
+        int phase;
+
+        ProfileSite(const char* name): name(name), serial(-1), phase(-1) {}
+
+        int get(){
+            Profiler* profiler = Profiler::current;
+            if(profiler == nullptr) return -1;
+            if(serial != profiler->serial){
+                serial = profiler->serial;
+                phase = profiler->phase_id(name);
+            }
+            return phase;
+        }
+    };
+
+    // time a native block as a profiler phase, see `CT_PROFILE_SCOPE()`
+    struct ProfileScope{
+        int phase;
+        ProfileScope(ProfileSite& site){
+            phase = site.get();
+            if(phase != -1) Profiler::current->begin(phase);
+        }
+        ~ProfileScope(){
+            if(phase != -1 && Profiler::current) Profiler::current->end();
+        }
+    };
+
+    // time the rest of the enclosing block as the phase `name`, a string literal
+    #define CT_PROFILE_SCOPE(name) \
+        static ct::ProfileSite _profile_site(name); \
+        ct::ProfileScope _profile_scope(_profile_site)
+
+    // record a native block into the running trace only
+    struct TraceScope{
+        bool active;
+        TraceScope(int trace_name){
+            active = trace_name != -1 && Profiler::current && Profiler::current->tracing;
+            if(active) Profiler::current->trace_begin(trace_name);
+        }
+        ~TraceScope(){
+            if(active && Profiler::current) Profiler::current->end();
+        }
+    };
+}
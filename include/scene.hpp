@@ -0,0 +1,119 @@
+#pragma once
+
+#include "pocketpy.h"
+
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    struct TransformSlot{
+        int parent;             // -1 for root nodes
+        bool alive;
+
+        // hierarchy, `children` keeps the insertion order of `Node.children`
+        PyVar node;
+        bool enabled;
+        std::vector<int> children;
+
+        // z-index and the cached sum of z-index of this node and all its ancestors
+        double z_index;
+        double total_z;
+        int z_stamp;
+
+        // local TRS, `position` and `scale` are the node's own vec2 objects
+        // so in-place edits like `node.position.x = 1` are seen here
+        PyVar position;
+        PyVar scale;
+        float rotation;
+
+        // local TRS that `world` was computed from
+        Vec2 cached_position;
+        float cached_rotation;
+        Vec2 cached_scale;
+
+        Mat3x3 world;
+        int version;            // bumped every time `world` is recomputed
+        int parent_version;     // parent's version that `world` was computed against
+        // `world` may be stale, set on the whole subtree so a clean slot never has a dirty ancestor
+        bool dirty;
+    };
+
+    struct SceneGraph{
+        PK_ALWAYS_PASS_BY_POINTER(SceneGraph)
+
+        std::vector<TransformSlot> slots;
+        std::vector<int> free_slots;
+
+        // persistent pre-order node lists, [0] for all nodes and [1] for enabled nodes
+        PyVar flat[2];
+        std::vector<int> flat_ids[2];
+        int flat_root[2];
+        bool flat_dirty;
+
+        // render order, enabled nodes stably sorted by total z-index
+        PyVar queue;
+        PyVar queue_source;     // the enabled list that `queue` was built from
+        std::vector<int> queue_ids;
+        bool z_dirty;
+        int z_pass;
+        // bumped whenever a node may have become active or inactive
+        int active_version;
+
+        SceneGraph(): flat{nullptr, nullptr}, flat_root{-1, -1}, flat_dirty(true),
+            queue(nullptr), queue_source(nullptr), z_dirty(true), z_pass(0), active_version(0) {}
+
+        int alloc(PyVar node, PyVar position, PyVar scale, int parent);
+        void release(int id);
+        void set_parent(int id, int parent);
+        void set_rotation(int id, float rotation);
+        void set_enabled(int id, bool enabled);
+        // check if a node and all its ancestors are enabled
+        bool is_active(int id) const;
+
+        // get the pre-order list of `root`'s subtree, rebuilt only if the hierarchy changed
+        PyVar flatten(VM* vm, int root, bool enabled_only);
+
+        void set_z_index(int id, double z_index);
+        double total_z_index(int id);
+        // get enabled nodes of `root`'s subtree in render order, kept between frames if nothing moved
+        PyVar render_queue(VM* vm, int root);
+        // get the descendants of `root` in the order of the last `render_queue()`,
+        // and the sum of their transform versions, which changes whenever one of them moves
+        PyVar render_subtree(VM* vm, int root);
+
+        // get the world matrix of a slot, recomputing it if the slot or any ancestor changed
+        // a clean chain costs one local TRS compare per ancestor, only dirty slots are recomputed
+        const Mat3x3& world(int id);
+        // recompute all changed world matrices in one top-down pass and mark every slot clean
+        void update_transforms();
+
+        void _gc_mark(VM* vm){
+            for(TransformSlot& s: slots){
+                if(!s.alive) continue;
+                PK_OBJ_MARK(s.node);
+                PK_OBJ_MARK(s.position);
+                PK_OBJ_MARK(s.scale);
+            }
+            for(PyVar list: flat){
+                if(list != nullptr) PK_OBJ_MARK(list);
+            }
+            if(queue != nullptr) PK_OBJ_MARK(queue);
+            if(queue_source != nullptr) PK_OBJ_MARK(queue_source);
+        }
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+
+    private:
+        void _check(int id) const;
+        bool _is_local_dirty(const TransformSlot& s) const;
+        void _unlink(int id);
+        double _total_z(int id);
+        void _update_z();
+        void _mark_subtree_dirty(int id);
+        // recompute the dirty slots from the root down to `id`
+        const Mat3x3& _refresh(int id);
+        // recompute `world` from the parent's, which must be up to date
+        void _compute_world(TransformSlot& s, const TransformSlot& parent);
+    };
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "scene.hpp"
+
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    struct CoroutineTask{
+        PyVar coroutine;        // nullptr when stopped or free
+        int owner;              // scene graph slot of the node running it
+        int epoch;              // bumped to invalidate timer entries of this task
+        bool waiting;           // parked until `deadline`
+        i64 deadline;           // in ticks, -1 if the owner is inactive or its time scale is 0
+        double remaining;       // owner seconds left, only valid when `deadline` is -1
+    };
+
+    struct CoroutineOwner{
+        std::vector<int> tasks; // in the order of `start()`
+        bool ready;
+        bool active;            // false while the node or an ancestor is disabled, its waits are frozen
+        float time_scale;
+        // the owner's clock is `base_local + (time - base_global) * time_scale`
+        double base_global;
+        double base_local;
+    };
+
+    struct TimerEntry{
+        int task;
+        int epoch;
+        i64 deadline;
+    };
+
+    // hierarchical timer wheel, 4 levels of 64 slots with 1ms ticks
+    struct TimerWheel{
+        static const int kBits = 6;
+        static const int kSize = 1 << kBits;
+        static const int kLevels = 4;
+
+        std::vector<TimerEntry> slots[kLevels][kSize];
+        std::vector<TimerEntry> overflow;   // more than 2^24 ticks ahead
+        i64 current;
+        int count;
+
+        TimerWheel(): current(0), count(0) {}
+
+        void insert(TimerEntry e);
+        // advance to tick `target`, appending expired entries to `out` in deadline order
+        void advance(i64 target, std::vector<TimerEntry>& out);
+    };
+
+    struct Scheduler{
+        PK_ALWAYS_PASS_BY_POINTER(Scheduler)
+
+        PyVar graph_obj;
+        Type wait_type;
+        std::vector<CoroutineTask> tasks;
+        std::vector<int> free_tasks;
+        std::vector<CoroutineOwner> owners;     // indexed by scene graph slot
+        std::vector<int> ready;                 // tasks resumed on the next `update()`
+        TimerWheel wheel;
+        double time;
+        int active_version;                     // `SceneGraph::active_version` of the last update
+
+        Scheduler(PyVar graph_obj, Type wait_type): graph_obj(graph_obj), wait_type(wait_type), time(0), active_version(-1) {}
+
+        void start(int owner, PyVar coroutine);
+        void stop(int owner, PyVar coroutine);
+        void stop_all(int owner);
+        // reset the owner state of a released scene graph slot
+        void release(int owner);
+        void set_ready(int owner);
+        // number of running coroutines of an owner
+        int count(int owner) const;
+
+        float get_time_scale(int owner) const;
+        void set_time_scale(int owner, float scale);
+        // scaled time of an owner in seconds
+        double local_time(int owner) const;
+
+        // advance the clock by `dt` seconds and resume ready and expired coroutines
+        void update(VM* vm, double dt);
+
+        void _gc_mark(VM* vm){
+            PK_OBJ_MARK(graph_obj);
+            for(CoroutineTask& t: tasks){
+                if(t.coroutine != nullptr) PK_OBJ_MARK(t.coroutine);
+            }
+        }
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+
+    private:
+        CoroutineOwner& _owner(int id);
+        int _alloc_task(int owner, PyVar coroutine);
+        void _free_task(int id);
+        void _reset_owner(CoroutineOwner& o);
+        void _stop_task(int id);
+        void _detach(int owner, int id);
+        void _park(int id, double seconds);
+        // owner seconds left of a parked coroutine, by the owner's current clock
+        double _remaining(const CoroutineTask& t, const CoroutineOwner& o) const;
+        // freeze or resume the waits of owners whose node was enabled or disabled
+        void _update_active(const SceneGraph& graph);
+
+        // buffers reused by `update()`
+        std::vector<TimerEntry> _expired;
+        std::vector<int> _running;
+        std::vector<int> _kept;
+    };
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "raylib.h"
+#include "scene.hpp"
+
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    struct SpriteQuad{
+        Vector2 tl, bl, br, tr;     // viewport pixels
+        float u0, v0, u1, v1;       // flips are baked into the texture coordinates
+        Color color;
+    };
+
+    struct MaterialTexture{
+        int loc;
+        unsigned int texture_id;
+    };
+
+    struct MaterialUniform{
+        int loc;
+        int type;                   // `SHADER_UNIFORM_FLOAT` to `SHADER_UNIFORM_VEC4`
+        float value[4];
+    };
+
+    // a shader and the extra textures and uniforms it draws with
+    // sprites are drawn, or recorded, with a copy, so values set later do not affect them
+    struct MaterialValues{
+        Shader shader;              // id 0 for the default shader
+        std::vector<MaterialTexture> textures;
+        std::vector<MaterialUniform> uniforms;
+
+        MaterialValues(Shader shader = Shader{0, nullptr}): shader(shader) {}
+
+        void set_texture(int loc, unsigned int texture_id);
+        void set_uniform(int loc, int type, const float* value);
+        bool operator==(const MaterialValues& other) const;
+        bool operator!=(const MaterialValues& other) const { return !(*this == other); }
+
+        void apply_uniforms() const;
+        // rlgl forgets extra textures whenever the render batch is drawn, so they are
+        // registered again for every batch that may contain sprites of the material
+        void apply_textures() const;
+    };
+
+    // the values of a python `Material`, set in `Material._apply()`
+    struct MaterialState{
+        PK_ALWAYS_PASS_BY_POINTER(MaterialState)
+
+        MaterialValues values;
+
+        MaterialState(Shader shader): values(shader) {}
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+    };
+
+    // a sprite recorded between `begin_deferred()` and `flush()`
+    struct DrawCommand{
+        double z;                   // total z-index of the node that drew it
+        int material;               // index into `DrawList::materials`, -1 for the default shader
+        unsigned int texture_id;
+        SpriteQuad quad;
+    };
+
+    // consecutive commands of a compiled `DrawList` that share the material and the texture
+    struct DrawRun{
+        int material;
+        unsigned int texture_id;
+        int first, count;           // range of `DrawList::commands`
+    };
+
+    // the sprites of a deferred pass, recorded on the CPU and replayed into rlgl in one go
+    // replaying only reads the compiled list, it touches no python objects
+    struct DrawList{
+        std::vector<DrawCommand> commands;      // recorded sprites
+        std::vector<MaterialValues> materials;  // distinct materials of the commands
+        std::vector<DrawRun> runs;
+
+        // index of `m` in `materials`, added if it is not there yet
+        int add_material(const MaterialValues& m);
+        // sort by (z, shader, material, texture) and group the commands into runs
+        void compile();
+        void clear(){
+            commands.clear();
+            materials.clear();
+            runs.clear();
+        }
+    };
+
+    // emits textured quads straight into the rlgl render batch
+    // rlgl merges consecutive quads of the same texture into one draw call,
+    // the material is only switched (and the batch flushed) when it really changes
+    //
+    // in deferred mode, sprites drawn with a sticky or the default material are recorded instead
+    // and sorted by (z, shader, material, texture) when flushed, anything else drawn in between flushes first
+    struct SpriteBatch{
+        PK_ALWAYS_PASS_BY_POINTER(SpriteBatch)
+
+        PyVar world_to_viewport;    // the `g.world_to_viewport` mat3x3, updated in place every frame
+        float pixel_per_unit;
+        unsigned int shader_id;     // shader bound by `set_material()`, 0 for the default shader
+        MaterialValues applied;     // material whose values are set on `shader_id`
+        bool sticky;                // `shader_id` was bound for the following sprites, not for a scope
+        int sprite_count;           // sprites drawn since the last `reset_stats()`
+        int shader_switches;
+        int draw_runs;              // runs replayed since the last `reset_stats()`, one texture bind each
+
+        SceneGraph* scene;          // non-null in deferred mode
+        bool scoped;                // a shader was bound for a scope, its sprites are not recorded
+        int deferred_material;      // sticky material for the next recorded sprites, index into `list.materials`
+        DrawList list;              // recorded sprites
+
+        SpriteBatch(PyVar world_to_viewport, float pixel_per_unit):
+            world_to_viewport(world_to_viewport), pixel_per_unit(pixel_per_unit),
+            shader_id(0), sticky(false), sprite_count(0), shader_switches(0), draw_runs(0),
+            scene(nullptr), scoped(false), deferred_material(-1) {}
+
+        // returns true if the material has changed
+        bool set_material(const MaterialValues& m, bool sticky);
+        bool set_shader(Shader shader, bool sticky){ return set_material(MaterialValues(shader), sticky); }
+        // go back to the default shader
+        void reset_shader();
+        // go back to the default shader if the current one is sticky
+        void release_shader();
+
+        // record sprites until `end_deferred()`, `scene` gives the total z-index of drawing nodes
+        void begin_deferred(SceneGraph* scene);
+        // draw the recorded sprites, call it before drawing anything that bypasses the batch
+        void flush();
+        void end_deferred();
+
+        // `transform` maps the sprite's local space to world space, or to screen space if `ui` is true
+        // `src` is in texels, `origin` is relative to the destination size
+        // `node` is the scene graph id of the drawing node, used for its z-index in deferred mode
+        void draw(const Mat3x3& transform, bool ui, Texture2D texture, Rectangle src, bool flip_x, bool flip_y, Color color, Vector2 origin, int node);
+        void emit(unsigned int texture_id, const SpriteQuad& quad);
+        // draw a compiled list, switching the material between runs
+        void replay(const DrawList& draw_list);
+        // bind the shader of `m` and set its values, flushing the batch if they change
+        void _bind_material(const MaterialValues& m);
+
+        void _gc_mark(VM* vm){
+            PK_OBJ_MARK(world_to_viewport);
+        }
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+    };
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "raylib.h"
+#include "sprite_batch.hpp"
+
+#include <string_view>
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    // a monospaced bitmap font, the texture is a grid of equal cells in the order of `chars`
+    // every codepoint takes one cell of width, codepoints that are not in the font are left blank
+    struct SpriteFont{
+        PK_ALWAYS_PASS_BY_POINTER(SpriteFont)
+
+        Texture2D texture;
+        int n_rows, n_cols;
+        int cell_width, cell_height;    // in texels
+        std::vector<int> cell_of;       // codepoint -> cell index, -1 if not in the font
+
+        SpriteFont(Texture2D texture, int n_rows, int n_cols, std::string_view chars);
+
+        int find_cell(int codepoint) const {
+            return codepoint >= 0 && codepoint < (int)cell_of.size() ? cell_of[codepoint] : -1;
+        }
+
+        // size of `text` at scale 1, lines are separated by '\n'
+        Vector2 measure(std::string_view text, float spacing, float line_spacing) const;
+        // `transform` maps to world space, or to screen space if `ui` is true, only its scale and position are used
+        // `origin` is relative to the size of the whole text, `align` places each line inside it, 0 for left and 1 for right
+        void draw(SpriteBatch& batch, const Mat3x3& transform, bool ui, std::string_view text, float spacing, float line_spacing, Color color, Vector2 origin, float align);
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+    };
+}
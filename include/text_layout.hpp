@@ -0,0 +1,51 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ct{
+    // bytes of the plain text that were inside a `<color=#rrggbb>` tag
+    struct ColorSpan{
+        int begin, end;
+        Color color;                // alpha is taken from the tint when drawn
+    };
+
+    // strips `<color=#rrggbb>...</color>` tags from `text`
+    // a tag is closed by the first `</color>` on the same line, unclosed tags are kept as is
+    void parse_color_markup(std::string_view text, std::string& out, std::vector<ColorSpan>& spans);
+
+    struct LayoutGlyph{
+        Rectangle dst;              // relative to the top-left corner of the box
+        Rectangle src;              // in texels of the font texture
+        int span;                   // index into `TextLayout::spans`, -1 for the tint
+    };
+
+    struct TextLayout{
+        std::vector<LayoutGlyph> glyphs;
+        std::vector<ColorSpan> spans;
+        Vector2 size;               // size of the bounding box
+        int last_used;
+    };
+
+    // word or character wrapped text inside a box, see raylib's `text_rectangle_bounds.c` example
+    void layout_text_boxed(TextLayout& out, Font font, std::string_view text, float width, float height, float font_size, float spacing, float line_spacing, bool limit_height, bool word_wrap);
+    // replays the glyph quads of a layout into the rlgl batch
+    void draw_text_layout(const TextLayout& layout, Font font, Vector2 position, Color tint);
+
+    // layouts keyed by text, font and box parameters, so text that does not change is laid out once
+    // the position of the box is not part of the key
+    struct TextLayoutCache{
+        std::unordered_map<std::string, TextLayout> layouts;
+        int tick;
+        int max_layouts;            // the least recently used half is dropped when full
+
+        TextLayoutCache(int max_layouts): tick(0), max_layouts(max_layouts) {}
+
+        const TextLayout& get(Font font, std::string_view text, float width, float height, float font_size, float spacing, float line_spacing, bool limit_height, bool word_wrap);
+        void clear(){ layouts.clear(); }
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ct{
+    // a fixed set of worker threads for data parallel loops of the engine
+    // only one loop runs at a time, and only the main thread starts them
+    struct ThreadPool{
+        ThreadPool(int worker_count);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // calls `f(0)` to `f(count-1)` on the workers and the calling thread, returns when all are done
+        void parallel_for(int count, const std::function<void(int)>& f);
+        int thread_count() const { return (int)workers.size() + 1; }
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable start_cv;
+        std::condition_variable done_cv;
+        const std::function<void(int)>* task;
+        int task_count;
+        int next_index;             // next index to run, guarded by `mutex`
+        int running;                // workers inside the current loop
+        int generation;             // bumped for every loop, so workers join each loop once
+        bool stopping;
+
+        void _worker_main();
+        void _run_indices(std::unique_lock<std::mutex>& lock);
+    };
+
+    // the pool shared by the engine, sized for the cpu, no workers without thread support
+    ThreadPool& get_thread_pool();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "pocketpy.h"
+#include "raylib.h"
+#include "sprite_batch.hpp"
+
+#include <vector>
+
+using namespace pkpy;
+
+namespace ct{
+    struct TileQuad{
+        int cx, cy;                 // cell of the tile
+        float x0, y0, x1, y1;       // local pixels
+        float u0, v0, u1, v1;       // flips are baked into the texture coordinates
+    };
+
+    struct TileChunk{
+        std::vector<TileQuad> quads;    // in the order of `add()`
+    };
+
+    // tiles of a tilemap grouped into square chunks of cells
+    // only chunks that intersect the viewport are drawn, as one textured run into the rlgl batch
+    struct TilemapMesh{
+        PK_ALWAYS_PASS_BY_POINTER(TilemapMesh)
+
+        int width, height;          // in cells
+        int grid_size;              // in pixels
+        int chunk_size;             // in cells
+        int chunks_x, chunks_y;
+        std::vector<TileChunk> chunks;
+
+        TilemapMesh(int width, int height, int grid_size, int chunk_size);
+
+        TileChunk* chunk_at(int cx, int cy);
+        // `src_x` and `src_y` are in texels, `flips` is 0b01 for x and 0b10 for y
+        void add(int cx, int cy, int src_x, int src_y, int flips, Texture2D texture);
+        // remove all tiles of a cell
+        void clear_cell(int cx, int cy);
+        void clear();
+
+        // returns the number of chunks drawn
+        int draw(SpriteBatch& batch, const Mat3x3& transform, Texture2D texture, float viewport_width, float viewport_height);
+
+        static void _register(VM* vm, PyVar mod, PyVar type);
+    };
+}
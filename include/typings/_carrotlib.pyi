@@ -1,6 +1,6 @@
 from c import int_p
 import raylib as rl
-from linalg import vec2
+from linalg import vec2, mat3x3
 
 GRAPHICS_API_OPENGL_33: bool
 GRAPHICS_API_OPENGL_ES2: bool
@@ -27,6 +27,13 @@ def get_documents_directory() -> str:
 def fast_apply(f: callable, a: list | tuple, *args) -> None:
     """Equivalent to `for x in a: f(x, *args)` but much faster."""
 
+def fast_apply_overridden(f: callable, base: type, hook: str, a: list | tuple, *args) -> None:
+    """Like `fast_apply` but skips every `x` whose type does not override `base`'s method `hook`.
+
+    Whether a type overrides `hook` is resolved again whenever the type changes along `a`, so skipped items never enter the VM.
+    An instance attribute named `hook` counts as an override.
+    """
+
 def vibrate(milliseconds: int, amplitude: int = -1):
     """Vibrate the device."""
 
@@ -36,11 +43,285 @@ def _request_hot_reload():
 def _get_cjk_codepoints() -> tuple[int_p, int]:
     ...
 
+def is_sdf_font(font: rl.Font) -> bool: ...
+def _set_sdf_text_uniforms(shader: rl.Shader, font: rl.Font, font_size: float) -> None: ...
+def prepare_text(font: rl.Font, text: str) -> None:
+    """rasterize missing glyphs of `text` if `font` is a `DynamicFont`, call it before measuring or drawing with raylib."""
+
+def _begin_ui_layer(target: rl.RenderTexture2D, x: float, y: float, zoom: float) -> None:
+    """render into `target` with its top-left corner at `(x, y)`, the result is premultiplied."""
+def _end_ui_layer(camera: rl.Camera2D) -> None: ...
+def _draw_ui_layer(target: rl.RenderTexture2D, dest: rl.Rectangle) -> None: ...
+
 def _rlDrawTextBoxed(render: bool, limitHeight: bool, lineSpacing: float, font: rl.Font, text: str, rec: rl.Rectangle, fontSize: float, spacing: float, wordWrap: bool, tint: rl.Color) -> vec2:
     ...
 
 def _bake_global_light(image: rl.Image_p, color: rl.Color, intensity: float) -> None:
     ...
 
+def get_light_kernel() -> str:
+    """name of the light baking kernel selected for this cpu: `avx2`, `sse2`, `neon` or `scalar`."""
+
+def _check_light_kernels() -> float:
+    """bake the same lights with the kernel and the per-texel reference, return the max difference."""
+
 def _bake_point_light(image: rl.Image_p, color: rl.Color, intensity: float, x: int, y: int, radius: int, cookie: rl.Image_p = None) -> None:
-    ...
\ No newline at end of file
+    ...
+
+def _load_light_target(width: int, height: int) -> rl.RenderTexture2D:
+    """float render texture for `LightmapBaker.render()`, RGBA8 where the GPU cannot render to float textures."""
+
+def _gen_light_falloff(size: int) -> rl.Image:
+    """grayscale image of the point light falloff."""
+
+class LightmapBaker:
+    """Updates a lightmap from its lights, only the texels of lights that changed since the last update.
+
+    Each light is `(color, intensity)` for a global light or `(color, intensity, x, y, radius, cookie)`
+    for a point light, in viewport pixels. The lightmap has one texel per `divisor` pixels.
+    """
+    dirty_texels: int
+    rgbm_range: float
+
+    def __init__(self, rgbm_range: float = 0) -> None:
+        """with `rgbm_range > 0` the texture of `bake()` is RGBA8 and texels are RGBM encoded, `rgb * a * rgbm_range`."""
+    def bake(self, image: rl.Image_p, texture: rl.Texture2D, lights: list[tuple], divisor: int = 1) -> bool:
+        """bake the changed texels of `image` on worker threads and upload them to `texture`, cookies are images."""
+    def render(self, target: rl.RenderTexture2D, falloff: rl.Texture2D, lights: list[tuple], divisor: int = 1) -> bool:
+        """redraw `target` with additive quads if any light changed, cookies are textures."""
+    def invalidate(self) -> None:
+        """the next update bakes or draws everything."""
+
+class SceneGraph:
+    """Native transform store of the scene tree.
+
+    Each node owns a slot with its parent slot, local TRS and a cached world matrix.
+    Slot `-1` means a detached node, whose transform is always identity.
+    """
+    def alloc(self, node, position: vec2, scale: vec2, parent: int) -> int:
+        """allocate a slot, `position` and `scale` are tracked by reference."""
+    def free(self, id: int) -> None: ...
+    def set_parent(self, id: int, parent: int) -> None: ...
+    def set_rotation(self, id: int, rotation: float) -> None: ...
+    def set_enabled(self, id: int, enabled: bool) -> None: ...
+    def is_active(self, id: int) -> bool:
+        """check if a node and all its ancestors are enabled."""
+    def flatten(self, root: int, enabled_only: bool) -> list:
+        """get the pre-order node list of `root`'s subtree.
+
+        The list is cached and only rebuilt after a node is added, destroyed,
+        reparented or enabled/disabled. Do not modify it.
+        """
+    def set_z_index(self, id: int, z_index: int | float) -> None: ...
+    def total_z_index(self, id: int) -> int | float:
+        """get the cached sum of z-index of a node and all its ancestors."""
+    def render_queue(self, root: int) -> list:
+        """get enabled nodes of `root`'s subtree stably sorted by total z-index.
+
+        The list is cached between frames if no node moved. Do not modify it.
+        """
+    def render_subtree(self, root: int) -> tuple[list, int]:
+        """get the descendants of `root` in the order of the last `render_queue()`.
+
+        The second item is the sum of their transform versions, it changes whenever one of them moves.
+        """
+    def transform(self, id: int) -> mat3x3:
+        """get a copy of the cached world matrix, recomputed if it is dirty.
+
+        In-place edits of `position` and `scale` are seen right away. If nothing changed,
+        it only compares the local TRS of the node and its ancestors.
+        """
+    def update_transforms(self) -> None:
+        """recompute all changed world matrices in one top-down pass and mark every slot clean."""
+
+class Scheduler:
+    """Native coroutine scheduler of the scene tree.
+
+    Coroutines are owned by scene graph slots. A coroutine that yields an instance of
+    `wait_type` is parked in a hierarchical timer wheel and not resumed until
+    `wait._seconds` of its owner's time have passed.
+    """
+    def __init__(self, scene_graph: SceneGraph, wait_type: type) -> None: ...
+    def start(self, owner: int, coroutine) -> None: ...
+    def stop(self, owner: int, coroutine) -> None: ...
+    def stop_all(self, owner: int) -> None: ...
+    def free(self, owner: int) -> None:
+        """stop all coroutines of a released slot and reset its state."""
+    def set_ready(self, owner: int) -> None:
+        """allow coroutines of `owner` to run, called after `on_ready`."""
+    def count(self, owner: int) -> int: ...
+    def get_time_scale(self, owner: int) -> float: ...
+    def set_time_scale(self, owner: int, scale: float) -> None: ...
+    def time(self, owner: int) -> float:
+        """get the scaled time of `owner` in seconds."""
+    def update(self, dt: float) -> None:
+        """advance the clock and resume ready and expired coroutines."""
+
+class Profiler:
+    """Per-phase frame profiler backed by `std::chrono::steady_clock`.
+
+    Each phase keeps a ring buffer of its total milliseconds in the last `capacity` frames.
+    Phases may nest, only top-level phases are stacked in the graph.
+    """
+    def __init__(self, capacity: int = 240) -> None: ...
+    def begin(self, phase: str) -> None: ...
+    def end(self) -> None:
+        """end the innermost open phase."""
+    def scope(self, phase: str) -> 'Profiler':
+        """begin `phase` and end it when the `with` block exits.
+
+        ```python
+        with profiler.scope('update'):
+            ...
+        ```
+        """
+    def __enter__(self) -> 'Profiler': ...
+    def __exit__(self, *args) -> None: ...
+    def new_frame(self) -> None:
+        """commit the current frame and start a new one, phases still open are ended first."""
+    def phases(self) -> list[str]: ...
+    def history(self, phase: str = None) -> list[float]:
+        """get recorded milliseconds from the oldest frame, `None` for the whole frame."""
+    def percentiles(self, phase: str = None) -> tuple[float, float, float]:
+        """get p50, p95 and p99 in milliseconds, `None` for the whole frame."""
+    def render_graph(self, height: float) -> None:
+        """draw stacked per-phase frame times into the current imgui window."""
+    def start_trace(self, frames: int, max_events: int = 262144) -> None:
+        """record the next `frames` frames into a chrome trace event file.
+
+        Events are buffered in a fixed-size arena of `max_events` and written to
+        `get_caches_directory()` after the capture stops. Events beyond the arena are dropped.
+        """
+    def is_tracing(self) -> bool: ...
+    def last_trace_path(self) -> str | None:
+        """get the path of the last written trace file."""
+
+class MaterialState:
+    """A shader and the extra textures and uniforms it draws with.
+
+    Sprites keep a copy of the values they were drawn with, so they can be changed between sprites.
+    """
+    def __init__(self, shader: rl.Shader) -> None: ...
+    def set_texture(self, loc: int, texture: rl.Texture2D) -> None:
+        """bind `texture` to the sampler at `loc`, ignored if `loc` is -1."""
+    def set_uniform(self, loc: int, value: float | vec2 | vec3 | vec4) -> None:
+        """set the uniform at `loc`, ignored if `loc` is -1."""
+
+class SpriteBatch:
+    """Draws textured quads straight into the rlgl render batch.
+
+    Consecutive quads of the same texture and material end up in one draw call.
+
+    Between `begin_deferred()` and `end_deferred()`, sprites drawn with a sticky or the default
+    material are recorded and drawn sorted by (total z-index, shader, material, texture) when flushed.
+    """
+    sprite_count: int       # sprites drawn since `reset_stats()`
+    shader_switches: int
+    draw_runs: int          # texture runs of recorded sprites, one texture bind each
+
+    def __init__(self, world_to_viewport: mat3x3, pixel_per_unit: float) -> None:
+        """`world_to_viewport` is read on every draw, update it in place."""
+    def draw(self, transform: mat3x3, texture: rl.Texture2D, src_rect: rl.Rectangle = None, flip_x=False, flip_y=False, color: rl.Color = None, origin: vec2 = None, ui=False, node: int = -1) -> None:
+        """draw a texture like `draw_texture`, `transform` is in screen space if `ui` is true.
+
+        `node` is the scene graph id of the drawing node, its total z-index sorts deferred sprites.
+        """
+    def set_shader(self, shader: rl.Shader, sticky=False) -> bool:
+        """bind `shader` if it is not bound yet, return true if it has changed.
+
+        A sticky shader stays bound for the following sprites until `release_shader()`.
+        """
+    def set_material(self, material: MaterialState, sticky=False) -> bool:
+        """like `set_shader()`, and set the values of `material` on its shader, return true if they have changed.
+
+        The values are copied, a sticky material draws the following sprites with the values of this call.
+        """
+    def reset_shader(self) -> None:
+        """go back to the default shader."""
+    def release_shader(self) -> None:
+        """go back to the default shader if the current one is sticky."""
+    def begin_deferred(self, scene_graph: SceneGraph) -> None:
+        """record sprites until `end_deferred()`."""
+    def flush(self) -> None:
+        """draw the recorded sprites and release a sticky shader.
+
+        Call it before drawing anything that does not go through the batch.
+        """
+    def end_deferred(self) -> None: ...
+    def reset_stats(self) -> None: ...
+
+class TilemapMesh:
+    """Tiles of a tilemap baked into square chunks of cells.
+
+    Only the chunks that intersect the viewport are drawn, each tile is one quad
+    of a single textured run in the rlgl batch.
+    """
+    def __init__(self, width: int, height: int, grid_size: int, chunk_size: int = 32) -> None: ...
+    def add(self, cx: int, cy: int, src_x: int, src_y: int, flips: int, texture: rl.Texture2D) -> None:
+        """add a tile at a cell, `flips` is 0b01 for x and 0b10 for y."""
+    def clear_cell(self, cx: int, cy: int) -> None:
+        """remove all tiles of a cell."""
+    def clear(self) -> None: ...
+    def draw(self, batch: SpriteBatch, transform: mat3x3, texture: rl.Texture2D, viewport_width: float, viewport_height: float) -> int:
+        """draw visible chunks with the batch's `world_to_viewport`, return the number of drawn chunks."""
+
+class TextureAtlas:
+    """Packs images into square pages, so sprites of different files share textures.
+
+    Entries are `(page, x, y, width, height)` tuples in texels of the page.
+    """
+    page_count: int
+
+    def __init__(self, page_size: int = 2048, padding: int = 2, gpu=True) -> None:
+        """without `gpu`, pages are only kept as images, e.g. for packing at build time."""
+    def add(self, name: str, image: rl.Image) -> tuple[int, int, int, int, int] | None:
+        """pack a copy of `image`, return None if it is larger than a page."""
+    def find(self, name: str) -> tuple[int, int, int, int, int] | None: ...
+    def add_page(self, image: rl.Image) -> int:
+        """add a page packed ahead of time, nothing else is packed into it."""
+    def set_entry(self, name: str, page: int, x: int, y: int, width: int, height: int) -> None: ...
+    def page_texture(self, page: int) -> rl.Texture2D: ...
+    def entries(self) -> dict[str, list[int]]: ...
+    def export_pages(self, prefix: str) -> bool:
+        """write every page to `{prefix}{index}.png`."""
+    def unload(self) -> None:
+        """free all pages and their textures."""
+
+class DynamicFont:
+    """A font whose glyphs are rasterized the first time they are needed.
+
+    Glyphs live in a grid of equal cells in one texture of `texture_size`,
+    the least recently used glyph is evicted when the grid is full.
+
+    With `sdf`, glyphs are signed distance fields drawn with `SDFTextMaterial`,
+    they are kept in a cache file of the caches directory.
+    """
+    font: rl.Font            # works with all raylib text functions
+    glyph_count: int         # glyphs in the texture
+    evictions: int
+    sdf: bool
+
+    def __init__(self, path: str, font_size: int, texture_size: int = 1024, sdf: bool = False) -> None: ...
+    def prepare(self, text: str) -> None:
+        """rasterize the glyphs of `text` that are not in the texture yet."""
+    def save_cache(self) -> bool:
+        """write new SDF glyphs to the cache file, `unload()` does it too."""
+    def unload(self) -> None: ...
+
+class SpriteFont:
+    """A monospaced bitmap font, the texture is a grid of equal cells in the order of `chars`.
+
+    Codepoints that are not in the font take a blank cell.
+    """
+    n_rows: int
+    n_cols: int
+    cell_width: int
+    cell_height: int
+
+    def __init__(self, texture: rl.Texture2D, n_rows: int, n_cols: int, chars: str) -> None: ...
+    def measure(self, text: str, spacing: float = 0, line_spacing: float = 0) -> vec2:
+        """size of `text` at scale 1, lines are separated by '\\n'."""
+    def draw(self, batch: SpriteBatch, transform: mat3x3, text: str, spacing: float = 0, color: rl.Color = None, origin: vec2 = None, align: float = 0.5, line_spacing: float = 0, ui=False) -> None:
+        """draw all glyphs in one textured run, `align` places each line inside the text, 0 for left and 1 for right."""
+    def find_cell(self, codepoint: int) -> int:
+        """cell index of `codepoint`, -1 if it is not in the font."""
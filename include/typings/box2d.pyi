@@ -33,8 +33,22 @@ class World:
     def point_cast(self, point: vec2) -> list['Body']:
         """query bodies that contain the point."""
 
-    def step(self, dt: float, velocity_iterations: int, position_iterations: int) -> None:
-        """step the simulation, e.g. world.step(1/60, 8, 3)"""
+    @property
+    def interpolation_alpha(self) -> float:
+        """how far the frame time is between the previous and the current fixed step, in [0, 1)."""
+
+    def set_fixed_step(self, hz: float, max_substeps: int = 8) -> None:
+        """enable fixed-step mode with `hz` steps per second, `hz <= 0` disables it.
+
+        In fixed-step mode, `step()` accumulates `dt` and runs at most `max_substeps` steps.
+        Pre/post step callbacks are called for each step.
+        """
+
+    def step(self, dt: float, velocity_iterations: int, position_iterations: int) -> int:
+        """step the simulation, e.g. world.step(1/60, 8, 3)
+
+        Return the number of steps taken.
+        """
 
 	# enum
 	# {
@@ -67,6 +81,12 @@ class Body:
 
     position: vec2
     rotation: float     # in radians (counter-clockwise)
+    @property
+    def interpolated_position(self) -> vec2:
+        """position blended between the last two fixed steps, for rendering."""
+    @property
+    def interpolated_rotation(self) -> float:
+        """rotation blended between the last two fixed steps, for rendering."""
     velocity: vec2      # linear velocity
     angular_velocity: float
     damping: float      # linear damping
@@ -284,6 +284,10 @@ class ProjectView:
                 if changed:
                     backend.config.use_precompile = use_precompile
                 imgui.same_line(spacing=16)
+                changed, use_atlas_prepack = imgui.checkbox("Prepack Atlas", backend.config.use_atlas_prepack)
+                if changed:
+                    backend.config.use_atlas_prepack = use_atlas_prepack
+                imgui.same_line(spacing=16)
                 changed, use_playground_console = imgui.checkbox("Console", backend.config.use_playground_console)
                 if changed:
                     backend.config.use_playground_console = use_playground_console
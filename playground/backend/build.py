@@ -82,6 +82,16 @@ def prebuild(project: str, hardcode_assets: bool):
         if task.returncode != 0:
             print("[WARNING]", "Precompile failed. Continue building without precompile.")
 
+    if config.use_atlas_prepack:
+        task = TaskCommand([
+            FRAMEWORK_EXE_PATH,
+            os.path.abspath("scripts/prepack_atlas.py"),
+            os.path.abspath(ANDROID_ASSETS_DIR),
+        ])
+        list(task)
+        if task.returncode != 0:
+            print("[WARNING]", "Atlas prepack failed. Continue building without prepacked atlas.")
+
     if hardcode_assets:
         if not os.path.exists('src/tmp'):
             os.mkdir('src/tmp')
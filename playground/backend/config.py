@@ -5,6 +5,7 @@ import json, os
 class Config:
     project: str = "examples/01_HelloWorld"
     use_precompile: bool = False
+    use_atlas_prepack: bool = False
     use_playground_console: bool = True
     use_release_build: bool = False
     use_profile_build: bool = False
@@ -0,0 +1,11 @@
+from _carrotlib import get_light_kernel, _check_light_kernels
+
+# max difference between the row kernels and `ct::reference` on global, clipped and cookie lights
+TOLERANCE = 3.6e-7
+
+diff = _check_light_kernels()
+if diff > TOLERANCE:
+    print("[ERROR]", f'{get_light_kernel()} light kernel differs from the reference by {diff}')
+    exit(1)
+
+print("[INFO]", f'{get_light_kernel()} light kernel matches the reference, max difference {diff}')
@@ -0,0 +1,58 @@
+import sys
+import os
+import json
+
+import raylib as rl
+from _carrotlib import TextureAtlas
+
+# must match `PREPACKED_ATLAS_MANIFEST` in carrotlib/_resources.py
+OUTPUT_DIR = 'prepacked_atlas'
+PAGE_SIZE = 2048
+PADDING = 2
+# larger images are kept as standalone textures
+MAX_IMAGE_SIZE = 512
+
+def traverse(root: str, rel: str, out: list):
+    for entry in sorted(os.listdir(os.path.join(root, rel))):
+        relpath = rel + '/' + entry
+        if os.path.isdir(os.path.join(root, relpath)):
+            traverse(root, relpath, out)
+        elif relpath.endswith(".png"):
+            out.append(relpath)
+
+project = sys.argv[2]
+paths = []
+if os.path.isdir(os.path.join(project, 'assets')):
+    traverse(project, 'assets', paths)
+
+images = []
+for path in paths:
+    image = rl.LoadImage(os.path.join(project, path))
+    if image.width > MAX_IMAGE_SIZE or image.height > MAX_IMAGE_SIZE:
+        rl.UnloadImage(image)
+        continue
+    images.append((path, image))
+
+# the skyline packer wastes less space on images sorted by height
+images.sort(key=lambda x: x[1].height, reverse=True)
+atlas = TextureAtlas(PAGE_SIZE, PADDING, False)
+for path, image in images:
+    atlas.add(path, image)
+    rl.UnloadImage(image)
+
+if atlas.page_count > 0:
+    output_dir = os.path.join(project, OUTPUT_DIR)
+    if not os.path.exists(output_dir):
+        os.mkdir(output_dir)
+    if not atlas.export_pages(os.path.join(output_dir, 'page_')):
+        print("[ERROR]", "failed to export atlas pages")
+        exit(1)
+    manifest = {
+        'pages': [f'{OUTPUT_DIR}/page_{i}.png' for i in range(atlas.page_count)],
+        'entries': atlas.entries(),
+    }
+    with open(os.path.join(output_dir, 'manifest.json'), 'w') as f:
+        f.write(json.dumps(manifest))
+
+print("[INFO]", f'{len(images)} images were packed into {atlas.page_count} atlas pages')
+atlas.unload()
@@ -1,8 +1,17 @@
 #include "appw.hpp"
 #include "light.hpp"
+#include "lightmap.hpp"
+#include "scene.hpp"
+#include "scheduler.hpp"
+#include "profiler.hpp"
+#include "sprite_batch.hpp"
+#include "tilemap.hpp"
+#include "atlas.hpp"
+#include "text_layout.hpp"
+#include "dynamic_font.hpp"
+#include "sprite_font.hpp"
 #include "imguiw.hpp"
-
-#include <regex>
+#include "rlgl.h"
 
 using namespace pkpy;
 
@@ -10,6 +19,7 @@ namespace ct{
 
 // https://github.com/raysan5/raylib/blob/master/examples/text/text_rectangle_bounds.c
 static Vector2 DrawTextBoxed(bool, bool, float, Font font, const char *text, Rectangle rec, float fontSize, float spacing, bool wordWrap, Color tint);   // Draw text using font inside rectangle limits
+static TextLayoutCache text_layout_cache(512);
 
 static const char* template_path = NULL;
 
@@ -21,8 +31,449 @@ const char* get_template_path(){
     return template_path;
 }
 
+bool is_overridden(VM* vm, Type type, Type base, StrName name){
+    return vm->find_name_in_mro(type, name) != vm->find_name_in_mro(base, name);
+}
+
+bool OverrideFilter::operator()(VM* vm, PyVar obj){
+    // an instance attribute shadows the class, e.g. `node.on_update = ...`
+    if(!is_tagged(obj) && obj->is_attr_valid() && obj->attr().contains(name)) return true;
+    Type t = vm->_tp(obj);
+    if(t != last_type){
+        last_type = t;
+        last_result = is_overridden(vm, t, base, name);
+    }
+    return last_result;
+}
+
+static void get_sequence_range(VM* vm, PyVar obj, PyVar*& begin, PyVar*& end){
+    if(is_type(obj, vm->tp_list)){
+        begin = PK_OBJ_GET(List, obj).begin();
+        end = PK_OBJ_GET(List, obj).end();
+    }else if(is_type(obj, vm->tp_tuple)){
+        begin = PK_OBJ_GET(Tuple, obj).begin();
+        end = PK_OBJ_GET(Tuple, obj).end();
+    }else{
+        vm->TypeError("expected a list or tuple");
+    }
+}
+
+// bound here, raylib wrapper types are only visible in this unit
+void MaterialState::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, shader: Shader)",
+        [](VM* vm, ArgsView args){
+            return vm->new_user_object<MaterialState>(CAST(Shader, args[1]));
+        });
+
+    vm->bind(type, "set_texture(self, loc: int, texture: Texture2D)",
+        [](VM* vm, ArgsView args){
+            MaterialState& self = _CAST(MaterialState&, args[0]);
+            self.values.set_texture(CAST(int, args[1]), CAST(Texture2D, args[2]).id);
+            return vm->None;
+        });
+
+    vm->bind(type, "set_uniform(self, loc: int, value: float | vec2 | vec3 | vec4)",
+        [](VM* vm, ArgsView args){
+            MaterialState& self = _CAST(MaterialState&, args[0]);
+            int loc = CAST(int, args[1]);
+            PyVar value = args[2];
+            if(is_type(value, vm->_tp_user<Vec2>())){
+                Vec2 v = _CAST(Vec2, value);
+                self.values.set_uniform(loc, SHADER_UNIFORM_VEC2, &v.x);
+            }else if(is_type(value, vm->_tp_user<Vec3>())){
+                Vec3 v = _CAST(Vec3, value);
+                self.values.set_uniform(loc, SHADER_UNIFORM_VEC3, &v.x);
+            }else if(is_type(value, vm->_tp_user<Vec4>())){
+                Vec4 v = _CAST(Vec4, value);
+                self.values.set_uniform(loc, SHADER_UNIFORM_VEC4, &v.x);
+            }else{
+                float v = CAST_F(value);
+                self.values.set_uniform(loc, SHADER_UNIFORM_FLOAT, &v);
+            }
+            return vm->None;
+        });
+}
+
+void SpriteBatch::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, world_to_viewport: mat3x3, pixel_per_unit: float)",
+        [](VM* vm, ArgsView args){
+            PyVar w2v = args[1];
+            if(!is_type(w2v, vm->_tp_user<Mat3x3>())) vm->TypeError("expected mat3x3 for world_to_viewport");
+            return vm->new_user_object<SpriteBatch>(w2v, CAST_F(args[2]));
+        });
+
+    vm->bind(type, "draw(self, transform: mat3x3, texture: Texture2D, src_rect: Rectangle = None, flip_x=False, flip_y=False, color: Color = None, origin: vec2 = None, ui=False, node: int = -1)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            const Mat3x3& transform = CAST(Mat3x3&, args[1]);
+            Texture2D texture = CAST(Texture2D, args[2]);
+            Rectangle src = {0, 0, (float)texture.width, (float)texture.height};
+            if(args[3] != vm->None) src = CAST(Rectangle, args[3]);
+            Color color = WHITE;
+            if(args[6] != vm->None) color = CAST(Color, args[6]);
+            Vector2 origin = {0.5f, 0.5f};
+            if(args[7] != vm->None) origin = CAST(Vector2, args[7]);
+            self.draw(transform, CAST(bool, args[8]), texture, src, CAST(bool, args[4]), CAST(bool, args[5]), color, origin, CAST(int, args[9]));
+            return vm->None;
+        });
+
+    vm->bind(type, "set_shader(self, shader: Shader, sticky=False) -> bool",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            return VAR(self.set_shader(CAST(Shader, args[1]), CAST(bool, args[2])));
+        });
+
+    vm->bind(type, "set_material(self, material: MaterialState, sticky=False) -> bool",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            return VAR(self.set_material(CAST(MaterialState&, args[1]).values, CAST(bool, args[2])));
+        });
+
+    vm->bind(type, "reset_shader(self)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            self.reset_shader();
+            return vm->None;
+        });
+
+    vm->bind(type, "release_shader(self)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            self.release_shader();
+            return vm->None;
+        });
+
+    vm->bind(type, "begin_deferred(self, scene_graph: SceneGraph)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            self.begin_deferred(&CAST(SceneGraph&, args[1]));
+            return vm->None;
+        });
+
+    vm->bind(type, "flush(self)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            self.flush();
+            return vm->None;
+        });
+
+    vm->bind(type, "end_deferred(self)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            self.end_deferred();
+            return vm->None;
+        });
+
+    vm->bind(type, "reset_stats(self)",
+        [](VM* vm, ArgsView args){
+            SpriteBatch& self = _CAST(SpriteBatch&, args[0]);
+            self.sprite_count = 0;
+            self.shader_switches = 0;
+            self.draw_runs = 0;
+            return vm->None;
+        });
+
+    PY_READONLY_FIELD(SpriteBatch, "sprite_count", sprite_count)
+    PY_READONLY_FIELD(SpriteBatch, "shader_switches", shader_switches)
+    PY_READONLY_FIELD(SpriteBatch, "draw_runs", draw_runs)
+}
+
+void TilemapMesh::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, width: int, height: int, grid_size: int, chunk_size: int = 32)",
+        [](VM* vm, ArgsView args){
+            int width = CAST(int, args[1]);
+            int height = CAST(int, args[2]);
+            int grid_size = CAST(int, args[3]);
+            int chunk_size = CAST(int, args[4]);
+            if(width < 0 || height < 0 || grid_size <= 0 || chunk_size <= 0) vm->ValueError("invalid tilemap size");
+            return vm->new_user_object<TilemapMesh>(width, height, grid_size, chunk_size);
+        });
+
+    vm->bind(type, "add(self, cx: int, cy: int, src_x: int, src_y: int, flips: int, texture: Texture2D)",
+        [](VM* vm, ArgsView args){
+            TilemapMesh& self = _CAST(TilemapMesh&, args[0]);
+            self.add(CAST(int, args[1]), CAST(int, args[2]), CAST(int, args[3]), CAST(int, args[4]), CAST(int, args[5]), CAST(Texture2D, args[6]));
+            return vm->None;
+        });
+
+    vm->bind(type, "clear_cell(self, cx: int, cy: int)",
+        [](VM* vm, ArgsView args){
+            TilemapMesh& self = _CAST(TilemapMesh&, args[0]);
+            self.clear_cell(CAST(int, args[1]), CAST(int, args[2]));
+            return vm->None;
+        });
+
+    vm->bind(type, "clear(self)",
+        [](VM* vm, ArgsView args){
+            TilemapMesh& self = _CAST(TilemapMesh&, args[0]);
+            self.clear();
+            return vm->None;
+        });
+
+    vm->bind(type, "draw(self, batch: SpriteBatch, transform: mat3x3, texture: Texture2D, viewport_width: float, viewport_height: float) -> int",
+        [](VM* vm, ArgsView args){
+            TilemapMesh& self = _CAST(TilemapMesh&, args[0]);
+            SpriteBatch& batch = CAST(SpriteBatch&, args[1]);
+            const Mat3x3& transform = CAST(Mat3x3&, args[2]);
+            int drawn = self.draw(batch, transform, CAST(Texture2D, args[3]), CAST_F(args[4]), CAST_F(args[5]));
+            return VAR(drawn);
+        });
+}
+
+void SpriteFont::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, texture: Texture2D, n_rows: int, n_cols: int, chars: str)",
+        [](VM* vm, ArgsView args){
+            Texture2D texture = CAST(Texture2D, args[1]);
+            int n_rows = CAST(int, args[2]);
+            int n_cols = CAST(int, args[3]);
+            if(n_rows <= 0 || n_cols <= 0) vm->ValueError("invalid number of rows or columns");
+            if(texture.width % n_cols != 0 || texture.height % n_rows != 0) vm->ValueError("texture size is not a multiple of the cell size");
+            return vm->new_user_object<SpriteFont>(texture, n_rows, n_cols, CAST(Str&, args[4]).sv());
+        });
+
+    vm->bind(type, "measure(self, text: str, spacing: float = 0, line_spacing: float = 0) -> vec2",
+        [](VM* vm, ArgsView args){
+            SpriteFont& self = _CAST(SpriteFont&, args[0]);
+            Vector2 size = self.measure(CAST(Str&, args[1]).sv(), CAST_F(args[2]), CAST_F(args[3]));
+            return VAR(Vec2(size.x, size.y));
+        });
+
+    vm->bind(type, "draw(self, batch: SpriteBatch, transform: mat3x3, text: str, spacing: float = 0, color: Color = None, origin: vec2 = None, align: float = 0.5, line_spacing: float = 0, ui=False)",
+        [](VM* vm, ArgsView args){
+            SpriteFont& self = _CAST(SpriteFont&, args[0]);
+            SpriteBatch& batch = CAST(SpriteBatch&, args[1]);
+            const Mat3x3& transform = CAST(Mat3x3&, args[2]);
+            Color color = WHITE;
+            if(args[5] != vm->None) color = CAST(Color, args[5]);
+            Vector2 origin = {0.5f, 0.5f};
+            if(args[6] != vm->None) origin = CAST(Vector2, args[6]);
+            self.draw(batch, transform, CAST(bool, args[9]), CAST(Str&, args[3]).sv(), CAST_F(args[4]), CAST_F(args[8]), color, origin, CAST_F(args[7]));
+            return vm->None;
+        });
+
+    vm->bind(type, "find_cell(self, codepoint: int) -> int",
+        [](VM* vm, ArgsView args){
+            SpriteFont& self = _CAST(SpriteFont&, args[0]);
+            return VAR(self.find_cell(CAST(int, args[1])));
+        });
+
+    PY_READONLY_FIELD(SpriteFont, "n_rows", n_rows)
+    PY_READONLY_FIELD(SpriteFont, "n_cols", n_cols)
+    PY_READONLY_FIELD(SpriteFont, "cell_width", cell_width)
+    PY_READONLY_FIELD(SpriteFont, "cell_height", cell_height)
+}
+
+// (page, x, y, width, height)
+static PyVar atlas_entry_to_tuple(VM* vm, const AtlasEntry* e){
+    if(e == nullptr) return vm->None;
+    Tuple t(5);
+    t[0] = VAR(e->page);
+    t[1] = VAR((int)e->rect.x);
+    t[2] = VAR((int)e->rect.y);
+    t[3] = VAR((int)e->rect.width);
+    t[4] = VAR((int)e->rect.height);
+    return VAR(std::move(t));
+}
+
+void TextureAtlas::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, page_size: int = 2048, padding: int = 2, gpu=True)",
+        [](VM* vm, ArgsView args){
+            int page_size = CAST(int, args[1]);
+            int padding = CAST(int, args[2]);
+            if(page_size <= 0 || padding < 0) vm->ValueError("invalid atlas page size or padding");
+            return vm->new_user_object<TextureAtlas>(page_size, padding, CAST(bool, args[3]));
+        });
+
+    vm->bind(type, "add(self, name: str, image: Image) -> tuple[int, int, int, int, int] | None",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            const Str& name = CAST(Str&, args[1]);
+            return atlas_entry_to_tuple(vm, self.add(name.sv(), CAST(Image, args[2])));
+        });
+
+    vm->bind(type, "find(self, name: str) -> tuple[int, int, int, int, int] | None",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            const Str& name = CAST(Str&, args[1]);
+            return atlas_entry_to_tuple(vm, self.find(name.sv()));
+        });
+
+    vm->bind(type, "add_page(self, image: Image) -> int",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            return VAR(self.add_page(CAST(Image, args[1])));
+        });
+
+    vm->bind(type, "set_entry(self, name: str, page: int, x: int, y: int, width: int, height: int)",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            const Str& name = CAST(Str&, args[1]);
+            int page = CAST(int, args[2]);
+            if(page < 0 || page >= self.pages.size()) vm->IndexError("atlas page out of range");
+            Rectangle rect = {CAST_F(args[3]), CAST_F(args[4]), CAST_F(args[5]), CAST_F(args[6])};
+            self.set_entry(name.sv(), page, rect);
+            return vm->None;
+        });
+
+    vm->bind(type, "page_texture(self, page: int) -> Texture2D",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            int page = CAST(int, args[1]);
+            if(page < 0 || page >= self.pages.size()) vm->IndexError("atlas page out of range");
+            return VAR(self.pages[page].texture);
+        });
+
+    vm->bind(type, "entries(self) -> dict[str, list[int]]",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            Dict d(vm);
+            for(auto& [name, e]: self.entries){
+                List l(5);
+                l[0] = VAR(e.page);
+                l[1] = VAR((int)e.rect.x);
+                l[2] = VAR((int)e.rect.y);
+                l[3] = VAR((int)e.rect.width);
+                l[4] = VAR((int)e.rect.height);
+                d.set(VAR(name), VAR(std::move(l)));
+            }
+            return VAR(std::move(d));
+        });
+
+    vm->bind(type, "export_pages(self, prefix: str) -> bool",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            return VAR(self.export_pages(CAST(Str&, args[1]).sv()));
+        });
+
+    vm->bind(type, "unload(self)",
+        [](VM* vm, ArgsView args){
+            TextureAtlas& self = _CAST(TextureAtlas&, args[0]);
+            self.unload();
+            return vm->None;
+        });
+
+    PY_READONLY_PROPERTY(TextureAtlas, "page_count: int", page_count)
+}
+
+void DynamicFont::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, path: str, font_size: int, texture_size: int = 1024, sdf: bool = False)",
+        [](VM* vm, ArgsView args){
+            const Str& path = CAST(Str&, args[1]);
+            int font_size = CAST(int, args[2]);
+            int texture_size = CAST(int, args[3]);
+            bool sdf = CAST(bool, args[4]);
+            if(font_size <= 0 || texture_size <= 0) vm->ValueError("invalid font size or texture size");
+            PyVar obj = vm->new_user_object<DynamicFont>();
+            DynamicFont& self = PK_OBJ_GET(DynamicFont, obj);
+            if(!self.load(path.c_str(), font_size, texture_size, sdf)){
+                self.unload();
+                vm->IOError(_S("failed to load font: ", path, " (or the texture is too small)"));
+            }
+            return obj;
+        });
+
+    vm->bind(type, "prepare(self, text: str)",
+        [](VM* vm, ArgsView args){
+            DynamicFont& self = _CAST(DynamicFont&, args[0]);
+            self.prepare(CAST(Str&, args[1]).sv());
+            return vm->None;
+        });
+
+    vm->bind(type, "save_cache(self) -> bool",
+        [](VM* vm, ArgsView args){
+            DynamicFont& self = _CAST(DynamicFont&, args[0]);
+            return VAR(self.save_cache());
+        });
+
+    vm->bind(type, "unload(self)",
+        [](VM* vm, ArgsView args){
+            DynamicFont& self = _CAST(DynamicFont&, args[0]);
+            self.unload();
+            return vm->None;
+        });
+
+    PY_READONLY_PROPERTY(DynamicFont, "font: Font", get_font)
+    PY_READONLY_PROPERTY(DynamicFont, "glyph_count: int", glyph_count)
+    PY_READONLY_FIELD(DynamicFont, "evictions", evictions)
+    PY_READONLY_FIELD(DynamicFont, "sdf", sdf)
+}
+
+// (color, intensity) for a global light, (color, intensity, x, y, r, cookie) for a point light
+// the cookie is an image for `bake_lights()` and a texture for `render_lights()`, or None
+// positions are in viewport pixels, the lightmap has one texel per `divisor` pixels
+static void parse_lights(VM* vm, const List& lights, bool gpu, int divisor, std::vector<LightBakeItem>& items){
+    if(divisor <= 0) vm->ValueError("invalid lightmap divisor");
+    auto scale = [divisor](int v){
+        // rounds towards negative infinity, lights may be left of or above the viewport
+        return v >= 0 ? v / divisor : -((-v + divisor - 1) / divisor);
+    };
+    items.reserve(lights.size());
+    for(PyVar obj: lights){
+        const Tuple& t = CAST(Tuple&, obj);
+        Color color = CAST(Color, t[0]);
+        f64 intensity = CAST(f64, t[1]);
+        if(t.size() == 2){
+            items.push_back(LightBakeItem::global(color, intensity));
+            continue;
+        }
+        if(t.size() != 6) vm->ValueError("expected a light tuple of 2 or 6 items");
+        int r = CAST(int, t[4]);
+        // a small light still lights its texel
+        if(r > 0) r = std::max((r + divisor / 2) / divisor, 1);
+        LightBakeItem item = LightBakeItem::point(color, intensity, scale(CAST(int, t[2])), scale(CAST(int, t[3])), r, nullptr);
+        if(t[5] != vm->None){
+            if(gpu) item.cookie_texture = CAST(Texture2D, t[5]).id;
+            else item.cookie = CAST(Image*, t[5]);
+        }
+        items.push_back(item);
+    }
+}
+
+void LightmapBaker::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, rgbm_range: float = 0)",
+        [](VM* vm, ArgsView args){
+            float rgbm_range = CAST_F(args[1]);
+            if(rgbm_range < 0) vm->ValueError("invalid RGBM range");
+            return vm->new_user_object<LightmapBaker>(rgbm_range);
+        });
+
+    vm->bind(type, "bake(self, image: Image_p, texture: Texture2D, lights: list, divisor: int = 1) -> bool",
+        [](VM* vm, ArgsView args){
+            LightmapBaker& self = _CAST(LightmapBaker&, args[0]);
+            Image* image = CAST(Image*, args[1]);
+            Texture2D texture = CAST(Texture2D, args[2]);
+            std::vector<LightBakeItem> items;
+            parse_lights(vm, CAST(List&, args[3]), false, CAST(int, args[4]), items);
+            CT_PROFILE_SCOPE("bake_light");
+            return VAR(self.bake(image, texture, std::move(items)));
+        });
+
+    vm->bind(type, "render(self, target: RenderTexture2D, falloff: Texture2D, lights: list, divisor: int = 1) -> bool",
+        [](VM* vm, ArgsView args){
+            LightmapBaker& self = _CAST(LightmapBaker&, args[0]);
+            RenderTexture2D target = CAST(RenderTexture2D, args[1]);
+            Texture2D falloff = CAST(Texture2D, args[2]);
+            std::vector<LightBakeItem> items;
+            parse_lights(vm, CAST(List&, args[3]), true, CAST(int, args[4]), items);
+            CT_PROFILE_SCOPE("render_lights");
+            return VAR(self.render(target, falloff, std::move(items)));
+        });
+
+    vm->bind(type, "invalidate(self)",
+        [](VM* vm, ArgsView args){
+            LightmapBaker& self = _CAST(LightmapBaker&, args[0]);
+            self.invalidate();
+            return vm->None;
+        });
+
+    PY_READONLY_FIELD(LightmapBaker, "dirty_texels", dirty_texels)
+    PY_READONLY_FIELD(LightmapBaker, "rgbm_range", rgbm_range)
+}
+
 PyVar add_module__ct(VM *vm){
     PyVar mod = vm->new_module("_carrotlib");
+    // fonts of the previous VM are unloaded, their texture ids may be reused
+    text_layout_cache.clear();
 
 #if PK_IS_DESKTOP_PLATFORM == 1
     int desktop_screen_width, desktop_screen_height;
@@ -34,6 +485,17 @@ PyVar add_module__ct(VM *vm){
     mod->attr().set("DESKTOP_SCREEN_HEIGHT", VAR(0));
 #endif
 
+    vm->register_user_class<SceneGraph>(mod, "SceneGraph");
+    vm->register_user_class<Scheduler>(mod, "Scheduler");
+    vm->register_user_class<Profiler>(mod, "Profiler");
+    vm->register_user_class<MaterialState>(mod, "MaterialState");
+    vm->register_user_class<SpriteBatch>(mod, "SpriteBatch");
+    vm->register_user_class<TilemapMesh>(mod, "TilemapMesh");
+    vm->register_user_class<TextureAtlas>(mod, "TextureAtlas");
+    vm->register_user_class<DynamicFont>(mod, "DynamicFont");
+    vm->register_user_class<SpriteFont>(mod, "SpriteFont");
+    vm->register_user_class<LightmapBaker>(mod, "LightmapBaker");
+
     vm->bind(mod, "vibrate(milliseconds, amplitude=-1)",
         [](VM* vm, ArgsView args){
             platform_vibrate(CAST(i64, args[0]), CAST(int, args[1]));
@@ -45,10 +507,21 @@ PyVar add_module__ct(VM *vm){
             Image* image = CAST(Image*, args[0]);
             Color color = CAST(Color, args[1]);
             f64 intensity = CAST(f64, args[2]);
+            CT_PROFILE_SCOPE("bake_light");
             bake_global_light(image, color, intensity);
             return vm->None;
         });
 
+    vm->bind(mod, "get_light_kernel() -> str",
+        [](VM* vm, ArgsView args){
+            return VAR(get_light_kernels().name);
+        });
+
+    vm->bind(mod, "_check_light_kernels() -> float",
+        [](VM* vm, ArgsView args){
+            return VAR(reference::check_kernels());
+        });
+
     vm->bind(mod, "_bake_point_light(image, color, intensity, x, y, r, cookie=None)",
         [](VM* vm, ArgsView args){
             Image* image = CAST(Image*, args[0]);
@@ -58,23 +531,28 @@ PyVar add_module__ct(VM *vm){
             int y = CAST(int, args[4]);
             int r = CAST(int, args[5]);
             Image* cookie = CAST(Image*, args[6]);
+            CT_PROFILE_SCOPE("bake_light");
             bake_point_light(image, color, intensity, x, y, r, cookie);
             return vm->None;
         });
 
+    vm->bind(mod, "_load_light_target(width: int, height: int) -> rl.RenderTexture2D",
+        [](VM* vm, ArgsView args){
+            return VAR(load_light_target(CAST(int, args[0]), CAST(int, args[1])));
+        });
+
+    vm->bind(mod, "_gen_light_falloff(size: int) -> rl.Image",
+        [](VM* vm, ArgsView args){
+            int size = CAST(int, args[0]);
+            if(size <= 0) vm->ValueError("invalid falloff size");
+            return VAR(gen_light_falloff(size));
+        });
+
     vm->bind_func(mod, "fast_apply", -1, [](VM* vm, ArgsView args){
         if(args.size() < 2) vm->TypeError("expected at least 2 arguments");
         PyVar* begin;
         PyVar* end;
-        if(is_type(args[1], vm->tp_list)){
-            begin = PK_OBJ_GET(List, args[1]).begin();
-            end = PK_OBJ_GET(List, args[1]).end();
-        }else if(is_type(args[1], vm->tp_tuple)){
-            begin = PK_OBJ_GET(Tuple, args[1]).begin();
-            end = PK_OBJ_GET(Tuple, args[1]).end();
-        }else{
-            vm->TypeError("expected a list or tuple as 2nd argument");
-        }
+        get_sequence_range(vm, args[1], begin, end);
         for(PyVar* item=begin; item!=end; item++){
             vm->s_data.push(args[0]);
             vm->s_data.push(PY_NULL);
@@ -85,6 +563,40 @@ PyVar add_module__ct(VM *vm){
         return vm->None;
     });
 
+    vm->bind_func(mod, "fast_apply_overridden", -1, [](VM* vm, ArgsView args){
+        if(args.size() < 4) vm->TypeError("expected at least 4 arguments");
+        vm->check_type(args[1], vm->tp_type);
+        Type base = PK_OBJ_GET(Type, args[1]);
+        StrName hook(CAST(Str&, args[2]));
+        PyVar* begin;
+        PyVar* end;
+        get_sequence_range(vm, args[3], begin, end);
+        Profiler* profiler = Profiler::current;
+        bool tracing = profiler != nullptr && profiler->tracing;
+        OverrideFilter overridden(base, hook);
+        for(PyVar* item=begin; item!=end; item++){
+            // skip nodes that keep the base no-op hook, without entering the VM
+            if(!overridden(vm, *item)) continue;
+            Type t = vm->_tp(*item);
+            // while tracing, each call is a "<hook> <class>" scope
+            int trace_name = -1;
+            if(tracing){
+                i64 key = ((i64)(int)t << 32) | (int)hook.index;
+                trace_name = profiler->trace_key(key, [&](){
+                    const Str& cls = CAST(Str&, vm->getattr(vm->_t(t), __name__));
+                    return std::string(hook.sv()) + " " + std::string(cls.sv());
+                });
+            }
+            TraceScope _scope(trace_name);
+            vm->s_data.push(args[0]);
+            vm->s_data.push(PY_NULL);
+            vm->s_data.push(*item);
+            for(int j=4; j<args.size(); j++) vm->s_data.push(args[j]);
+            vm->vectorcall(args.size()-3);
+        }
+        return vm->None;
+    });
+
     vm->bind(mod, "load_asset(name: str)",
         [](VM* vm, ArgsView args){
             const Str& name = CAST(Str&, args[0]);
@@ -185,168 +697,78 @@ PyVar add_module__ct(VM *vm){
     mod->attr().set("GRAPHICS_API_OPENGL_ES3", vm->False);
 #endif
 
-    vm->bind(mod, "_rlDrawTextBoxed(render: bool, limitHeight: bool, lineSpacing: float, font: rl.Font, text: str, rec: rl.Rectangle, fontSize: float, spacing: float, wordWrap: bool, tint: rl.Color) -> vec2", &DrawTextBoxed);
-
-    return mod;
-}
-
-// Draw text using font inside rectangle limits
-static Vector2 DrawTextBoxed(bool render, bool limitHeight, float lineSpacing, Font font, const char *text, Rectangle rec, float fontSize, float spacing, bool wordWrap, Color tint)
-{
-    std::string text_string(text);
-    // parse <color=#rrggbb>...</color>
-    std::map<int, Color> color_tags;
-    static const std::regex color_regex("<color=#([0-9a-fA-F]{6})>(.*?)</color>");
-    int deleted_count = 0;
-    // iterate over all color tags
-    std::sregex_iterator color_match_it(text_string.begin(), text_string.end(), color_regex);
-    std::sregex_iterator _end;
-    for (; color_match_it != _end; ++color_match_it) {
-        std::smatch color_match = *color_match_it;
-        int start = color_match.position(0);
-        int end = start + color_match.length(0);
-        std::string hex_group = color_match[1];
-        std::string text_group = color_match[2];
-        unsigned int r, g, b;
-        sscanf(hex_group.c_str(), "%02x%02x%02x", &r, &g, &b);
-        // calculate new index after deleting color tags
-        int new_index = start - deleted_count;
-        for(int i=0; i<text_group.size(); i++){
-            color_tags[new_index+i] = Color{ (unsigned char)r, (unsigned char)g, (unsigned char)b, tint.a };
-        }
-        deleted_count += color_match.length(0) - text_group.length();
-    }
-    // delete all color tags
-    text_string = std::regex_replace(text_string, color_regex, "$2");
-    text = text_string.c_str();
-
-#define MOVE_NEXT_LINE()  { textOffsetY += (font.baseSize + lineSpacing)*scaleFactor; textOffsetX = 0; }
-
-    int length = TextLength(text);  // Total length in bytes of the text, scanned by codepoints in loop
-
-    float textOffsetY = 0;          // Offset between lines (on line break '\n')
-    float textOffsetX = 0.0f;       // Offset X to next character to draw
-
-    float scaleFactor = fontSize/(float)font.baseSize;     // Character rectangle scaling factor
-
-    // Word/character wrapping mechanism variables
-    enum { MEASURE_STATE = 0, DRAW_STATE = 1 };
-    int state = wordWrap? MEASURE_STATE : DRAW_STATE;
-
-    int startLine = -1;         // Index where to begin drawing (where a line begins)
-    int endLine = -1;           // Index where to stop drawing (where a line ends)
-    int lastk = -1;             // Holds last value of the character position
-
-    for (int i = 0, k = 0; i < length; i++, k++)
-    {
-        // Get next codepoint from byte string and glyph index in font
-        int codepointByteCount = 0;
-        int codepoint = GetCodepoint(&text[i], &codepointByteCount);
-        int index = GetGlyphIndex(font, codepoint);
+    vm->bind(mod, "prepare_text(font: rl.Font, text: str)",
+        [](VM* vm, ArgsView args){
+            DynamicFont* dynamic = DynamicFont::find(CAST(Font, args[0]));
+            if(dynamic != nullptr) dynamic->prepare(CAST(Str&, args[1]).sv());
+            return vm->None;
+        });
 
-        // NOTE: Normally we exit the decoding sequence as soon as a bad byte is found (and return 0x3f)
-        // but we need to draw all of the bad bytes using the '?' symbol moving one byte
-        if (codepoint == 0x3f) codepointByteCount = 1;
-        i += (codepointByteCount - 1);
+    vm->bind(mod, "is_sdf_font(font: rl.Font) -> bool",
+        [](VM* vm, ArgsView args){
+            DynamicFont* dynamic = DynamicFont::find(CAST(Font, args[0]));
+            return VAR(dynamic != nullptr && dynamic->sdf);
+        });
 
-        float glyphWidth = 0;
-        if (codepoint != '\n')
-        {
-            glyphWidth = (font.glyphs[index].advanceX == 0) ? font.recs[index].width*scaleFactor : font.glyphs[index].advanceX*scaleFactor;
+    vm->bind(mod, "_set_sdf_text_uniforms(shader: rl.Shader, font: rl.Font, font_size: float)",
+        [](VM* vm, ArgsView args){
+            Shader shader = CAST(Shader, args[0]);
+            DynamicFont* dynamic = DynamicFont::find(CAST(Font, args[1]));
+            if(dynamic == nullptr) return vm->None;
+            float smoothing = dynamic->sdf_smoothing(CAST_F(args[2]));
+            // uniforms are not part of the render batch, text drawn before still uses the old value
+            rlDrawRenderBatchActive();
+            SetShaderValue(shader, GetShaderLocation(shader, "smoothing"), &smoothing, SHADER_UNIFORM_FLOAT);
+            return vm->None;
+        });
 
-            if (i + 1 < length) glyphWidth = glyphWidth + spacing;
-        }
+    vm->bind(mod, "_begin_ui_layer(target: rl.RenderTexture2D, x: float, y: float, zoom: float)",
+        [](VM* vm, ArgsView args){
+            BeginTextureMode(CAST(RenderTexture2D, args[0]));
+            ClearBackground(BLANK);
+            // the layer's top-left corner is at `(x, y)` in viewport pixels
+            BeginMode2D(Camera2D{Vector2{0, 0}, Vector2{CAST_F(args[1]), CAST_F(args[2])}, 0, CAST_F(args[3])});
+            // alpha is accumulated instead of squared, so the layer ends up premultiplied
+            rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+            BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+            return vm->None;
+        });
 
-        // NOTE: When wordWrap is ON we first measure how much of the text we can draw before going outside of the rec container
-        // We store this info in startLine and endLine, then we change states, draw the text between those two variables
-        // and change states again and again recursively until the end of the text (or until we get outside of the container).
-        // When wordWrap is OFF we don't need the measure state so we go to the drawing state immediately
-        // and begin drawing on the next line before we can get outside the container.
-        if (state == MEASURE_STATE)
-        {
-            // TODO: There are multiple types of spaces in UNICODE, maybe it's a good idea to add support for more
-            // Ref: http://jkorpela.fi/chars/spaces.html
-            if ((codepoint == ' ') || (codepoint == '\t') || (codepoint == '\n')) endLine = i;
-
-            if ((textOffsetX + glyphWidth) > rec.width)
-            {
-                endLine = (endLine < 1)? i : endLine;
-                if (i == endLine) endLine -= codepointByteCount;
-                if ((startLine + codepointByteCount) == endLine) endLine = (i - codepointByteCount);
-
-                state = !state;
-            }
-            else if ((i + 1) == length)
-            {
-                endLine = i;
-                state = !state;
-            }
-            else if (codepoint == '\n') state = !state;
-
-            if (state == DRAW_STATE)
-            {
-                textOffsetX = 0;
-                i = startLine;
-                glyphWidth = 0;
-
-                // Save character position when we switch states
-                int tmp = lastk;
-                lastk = k - 1;
-                k = tmp;
-            }
-        }
-        else
-        {
-            if (codepoint == '\n')
-            {
-                if (!wordWrap)
-                {
-                    MOVE_NEXT_LINE()
-                }
-            }
-            else
-            {
-                if (!wordWrap && ((textOffsetX + glyphWidth) > rec.width))
-                {
-                    MOVE_NEXT_LINE()
-                }
-
-                // When text overflows rectangle height limit, just stop drawing
-
-                if(limitHeight){
-                    if ((textOffsetY + font.baseSize*scaleFactor) > rec.height) break;
-                }
-                
-                // Draw selection background
-                // Draw current character glyph
-                if ((codepoint != ' ') && (codepoint != '\t'))
-                {
-                    if(render){
-                        auto it = color_tags.find(i);
-                        Color tint_c = (it != color_tags.end())? it->second : tint;
-                        DrawTextCodepoint(font, codepoint, Vector2{ rec.x + textOffsetX, rec.y + textOffsetY }, fontSize, tint_c);
-                    }
-                }
-            }
+    vm->bind(mod, "_end_ui_layer(camera: rl.Camera2D)",
+        [](VM* vm, ArgsView args){
+            EndBlendMode();
+            EndMode2D();
+            EndTextureMode();
+            // `EndTextureMode()` resets the transform, go back to the camera of the ui pass
+            BeginMode2D(CAST(Camera2D, args[0]));
+            return vm->None;
+        });
 
-            if (wordWrap && (i == endLine))
-            {
-                MOVE_NEXT_LINE()
-                startLine = endLine;
-                endLine = -1;
-                glyphWidth = 0;
-                k = lastk;
+    vm->bind(mod, "_draw_ui_layer(target: rl.RenderTexture2D, dest: rl.Rectangle)",
+        [](VM* vm, ArgsView args){
+            RenderTexture2D target = CAST(RenderTexture2D, args[0]);
+            Rectangle src = {0, 0, (float)target.texture.width, -(float)target.texture.height};
+            BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+            DrawTexturePro(target.texture, src, CAST(Rectangle, args[1]), Vector2{0, 0}, 0, WHITE);
+            EndBlendMode();
+            return vm->None;
+        });
 
-                state = !state;
-            }
-        }
+    vm->bind(mod, "_rlDrawTextBoxed(render: bool, limitHeight: bool, lineSpacing: float, font: rl.Font, text: str, rec: rl.Rectangle, fontSize: float, spacing: float, wordWrap: bool, tint: rl.Color) -> vec2", &DrawTextBoxed);
 
-        if ((textOffsetX != 0) || (codepoint != ' ')) textOffsetX += glyphWidth;  // avoid leading spaces
-    }
+    return mod;
+}
 
-    // return size of the bounding box
-    return Vector2{ textOffsetX, textOffsetY };
-#undef MOVE_NEXT_LINE
+// Draw text using font inside rectangle limits
+static Vector2 DrawTextBoxed(bool render, bool limitHeight, float lineSpacing, Font font, const char *text, Rectangle rec, float fontSize, float spacing, bool wordWrap, Color tint)
+{
+    CT_PROFILE_SCOPE("draw_text_boxed");
+    DynamicFont* dynamic = DynamicFont::find(font);
+    if(dynamic != nullptr) dynamic->prepare(text);
+    // `controls.Text` measures and renders the same text every frame, only the first call lays it out
+    const TextLayout& layout = text_layout_cache.get(font, text, rec.width, rec.height, fontSize, spacing, lineSpacing, limitHeight, wordWrap);
+    if(render) draw_text_layout(layout, font, Vector2{ rec.x, rec.y }, tint);
+    return layout.size;
 }
 
 void setup_imgui_font(){
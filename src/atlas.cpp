@@ -0,0 +1,119 @@
+#include "atlas.hpp"
+
+#include <cstring>
+
+// imgui_draw.cpp keeps its copy static as well
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+namespace ct{
+
+struct AtlasPacker{
+    stbrp_context context;
+    std::vector<stbrp_node> nodes;
+
+    AtlasPacker(int size): nodes(size){
+        stbrp_init_target(&context, size, size, nodes.data(), (int)nodes.size());
+    }
+};
+
+TextureAtlas::~TextureAtlas(){
+    // textures are released by `unload()`, the GL context may be gone at this point
+    for(AtlasPage& page: pages){
+        if(page.image.data != nullptr) UnloadImage(page.image);
+        delete page.packer;
+    }
+}
+
+const AtlasEntry* TextureAtlas::add(std::string_view name, Image image){
+    auto it = entries.find(name);
+    if(it != entries.end()) return &it->second;
+
+    stbrp_rect r;
+    r.id = 0;
+    r.w = image.width + padding * 2;
+    r.h = image.height + padding * 2;
+    if(r.w > page_size || r.h > page_size) return nullptr;
+
+    // first fit over the existing pages, then a new one
+    int index = -1;
+    for(int i=0; i<pages.size(); i++){
+        if(pages[i].packer == nullptr) continue;
+        if(stbrp_pack_rects(&pages[i].packer->context, &r, 1) && r.was_packed){
+            index = i;
+            break;
+        }
+    }
+    if(index == -1){
+        AtlasPage page;
+        page.image = GenImageColor(page_size, page_size, BLANK);
+        page.texture = gpu ? LoadTextureFromImage(page.image) : Texture2D{};
+        page.packer = new AtlasPacker(page_size);
+        pages.push_back(page);
+        index = (int)pages.size() - 1;
+        stbrp_pack_rects(&pages[index].packer->context, &r, 1);
+    }
+
+    AtlasPage& page = pages[index];
+    Rectangle rect = {(float)(r.x + padding), (float)(r.y + padding), (float)image.width, (float)image.height};
+
+    Image copy = ImageCopy(image);
+    ImageFormat(&copy, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    int row_size = copy.width * 4;
+    for(int y=0; y<copy.height; y++){
+        unsigned char* dst = (unsigned char*)page.image.data + ((int)rect.y + y) * page_size * 4 + (int)rect.x * 4;
+        memcpy(dst, (unsigned char*)copy.data + y * row_size, row_size);
+    }
+    if(gpu) UpdateTextureRec(page.texture, rect, copy.data);
+    UnloadImage(copy);
+
+    auto res = entries.emplace(std::string(name), AtlasEntry{index, rect});
+    return &res.first->second;
+}
+
+const AtlasEntry* TextureAtlas::find(std::string_view name) const{
+    auto it = entries.find(name);
+    if(it == entries.end()) return nullptr;
+    return &it->second;
+}
+
+int TextureAtlas::add_page(Image image){
+    AtlasPage page;
+    page.image = ImageCopy(image);
+    page.texture = Texture2D{};
+    page.packer = nullptr;
+    if(gpu){
+        // nothing is packed into it anymore, so the pixels are not needed on the CPU
+        page.texture = LoadTextureFromImage(page.image);
+        UnloadImage(page.image);
+        page.image = Image{};
+    }
+    pages.push_back(page);
+    return (int)pages.size() - 1;
+}
+
+void TextureAtlas::set_entry(std::string_view name, int page, Rectangle rect){
+    entries[std::string(name)] = AtlasEntry{page, rect};
+}
+
+bool TextureAtlas::export_pages(std::string_view prefix) const{
+    for(int i=0; i<pages.size(); i++){
+        if(pages[i].image.data == nullptr) return false;
+        std::string path = std::string(prefix) + std::to_string(i) + ".png";
+        if(!ExportImage(pages[i].image, path.c_str())) return false;
+    }
+    return true;
+}
+
+void TextureAtlas::unload(){
+    for(AtlasPage& page: pages){
+        if(page.texture.id != 0) UnloadTexture(page.texture);
+        if(page.image.data != nullptr) UnloadImage(page.image);
+        delete page.packer;
+    }
+    pages.clear();
+    entries.clear();
+}
+
+}   // namespace ct
@@ -1,4 +1,8 @@
 #include "box2dw.hpp"
+#include "appw.hpp"
+#include "profiler.hpp"
+
+#include <cmath>
 
 namespace pkpy{
 
@@ -16,6 +20,9 @@ void PyBody::_register(VM* vm, PyVar mod, PyVar type){
             body.body = world.world.CreateBody(&def);
             body.node_like = node;
             body.with_callback = CAST(bool, args[3]);
+            body._world = &world;
+            body._prev_position = body.body->GetPosition();
+            body._prev_rotation = body.body->GetAngle();
             return obj;
         });
 
@@ -30,6 +37,8 @@ void PyBody::_register(VM* vm, PyVar mod, PyVar type){
 
     PY_PROPERTY(PyBody, "position: vec2", get_position, set_position)
     PY_PROPERTY(PyBody, "rotation: float", get_rotation, set_rotation)
+    PY_READONLY_PROPERTY(PyBody, "interpolated_position: vec2", get_interpolated_position)
+    PY_READONLY_PROPERTY(PyBody, "interpolated_rotation: float", get_interpolated_rotation)
     PY_PROPERTY(PyBody, "velocity: vec2", get_velocity, set_velocity)
     PY_PROPERTY(PyBody, "angular_velocity: float", _b2Body()->GetAngularVelocity, _b2Body()->SetAngularVelocity)
     PY_PROPERTY(PyBody, "damping: float", _b2Body()->GetLinearDamping, _b2Body()->SetLinearDamping)
@@ -225,6 +234,7 @@ struct MyBoxCastCallback: b2QueryCallback{
 };
 
 void PyContactListener::_contact_f(b2Contact* contact, StrName name){
+    CT_PROFILE_SCOPE("b2_contact");
     PyObject* a = get_body_object(contact->GetFixtureA()->GetBody());
     PyObject* b = get_body_object(contact->GetFixtureB()->GetBody());
     PyBody& bodyA = a->as<PyBody>();
@@ -237,8 +247,21 @@ void PyContactListener::_contact_f(b2Contact* contact, StrName name){
     if(f != nullptr) vm->call_method(self, f, PyVar(vm->_tp_user<PyBody>(), a));
 }
 
+b2Vec2 PyBody::get_interpolated_position() const{
+    float t = _world->alpha;
+    b2Vec2 curr = body->GetPosition();
+    return b2Vec2(_prev_position.x + (curr.x - _prev_position.x) * t, _prev_position.y + (curr.y - _prev_position.y) * t);
+}
+
+float PyBody::get_interpolated_rotation() const{
+    float t = _world->alpha;
+    // box2d angles are not wrapped, so a plain lerp is fine
+    return _prev_rotation + (body->GetAngle() - _prev_rotation) * t;
+}
+
 /****************** PyWorld ******************/
-PyWorld::PyWorld(VM* vm): world(b2Vec2(0, 0)), _contact_listener(vm), _debug_draw(vm){
+PyWorld::PyWorld(VM* vm): world(b2Vec2(0, 0)), _contact_listener(vm), _debug_draw(vm),
+    fixed_dt(0), max_substeps(8), accumulator(0), alpha(1){
     _debug_draw.draw_like = vm->None;
     world.SetAllowSleeping(true);
     world.SetAutoClearForces(true);
@@ -246,11 +269,78 @@ PyWorld::PyWorld(VM* vm): world(b2Vec2(0, 0)), _contact_listener(vm), _debug_dra
     world.SetDebugDraw(&_debug_draw);
 }
 
+void PyWorld::_substep(VM* vm, float dt, int velocity_iterations, int position_iterations){
+    // nodes that keep `carrotlib.Node`'s no-op callbacks are skipped
+    Type node_t = -1;
+    PyVar cl = vm->_modules.try_get("carrotlib");
+    if(cl != nullptr){
+        PyVar node_type = cl->attr().try_get("Node");
+        if(node_type != nullptr) node_t = PK_OBJ_GET(Type, node_type);
+    }
+
+    auto f = [node_t](VM* vm, b2Body* p, StrName name){
+        ct::OverrideFilter overridden(node_t, name);
+        while(p != nullptr){
+            PyObject* body_obj = get_body_object(p);
+            PyBody& body = body_obj->as<PyBody>();
+            if(body.with_callback && !body._is_destroyed){
+                if(body.node_like != vm->None){
+                    Type t = vm->_tp(body.node_like);
+                    bool skip = node_t != -1 && vm->issubclass(t, node_t) && !overridden(vm, body.node_like);
+                    if(!skip) vm->call_method(body.node_like, name);
+                }
+            }
+            p = p->GetNext();
+        }
+    };
+
+    DEF_SNAME(on_box2d_pre_step);
+    DEF_SNAME(on_box2d_post_step);
+    {
+        CT_PROFILE_SCOPE("b2_pre_step");
+        f(vm, world.GetBodyList(), on_box2d_pre_step);
+    }
+    // remember transforms after pre-step callbacks, which may teleport bodies
+    for(b2Body* p = world.GetBodyList(); p != nullptr; p = p->GetNext()){
+        PyBody& body = get_body_object(p)->as<PyBody>();
+        body._prev_position = p->GetPosition();
+        body._prev_rotation = p->GetAngle();
+    }
+    {
+        // contact callbacks run inside
+        CT_PROFILE_SCOPE("b2_step");
+        world.Step(dt, velocity_iterations, position_iterations);
+    }
+    {
+        CT_PROFILE_SCOPE("b2_post_step");
+        f(vm, world.GetBodyList(), on_box2d_post_step);
+    }
+
+    // destroy bodies which are marked as destroyed
+    b2Body* p = world.GetBodyList();
+    while(p != nullptr){
+        b2Body* next = p->GetNext();
+        PyBody& body = get_body_object(p)->as<PyBody>();
+        if(body._is_destroyed){
+            body.body->GetWorld()->DestroyBody(body.body);
+            body.body = nullptr;
+            body._fixture = nullptr;
+            body.node_like = nullptr;
+        }
+        p = next;
+    }
+}
+
 void PyWorld::_register(VM* vm, PyVar mod, PyVar type){
     vm->bind_func(type, __new__, 1, [](VM* vm, ArgsView args){
         return vm->new_user_object<PyWorld>(vm);
     });
 
+    vm->bind_property(type, "interpolation_alpha: float", [](VM* vm, ArgsView args){
+        PyWorld& self = _CAST(PyWorld&, args[0]);
+        return VAR(self.alpha);
+    });
+
     // gravity
     vm->bind_property(type, "gravity: vec2", [](VM* vm, ArgsView args){
         PyWorld& self = _CAST(PyWorld&, args[0]);
@@ -304,7 +394,20 @@ void PyWorld::_register(VM* vm, PyVar mod, PyVar type){
         return VAR(std::move(callback.result));
     });
 
-    vm->bind(type, "step(self, dt: float, velocity_iterations: int, position_iterations: int)",
+    vm->bind(type, "set_fixed_step(self, hz: float, max_substeps: int = 8)",
+        [](VM* vm, ArgsView args){
+            PyWorld& self = _CAST(PyWorld&, args[0]);
+            float hz = CAST_F(args[1]);
+            int max_substeps = CAST(int, args[2]);
+            if(max_substeps < 1) vm->ValueError("max_substeps must be at least 1");
+            self.fixed_dt = hz > 0 ? 1.0f / hz : 0.0f;
+            self.max_substeps = max_substeps;
+            self.accumulator = 0;
+            self.alpha = 1;
+            return vm->None;
+        });
+
+    vm->bind(type, "step(self, dt: float, velocity_iterations: int, position_iterations: int) -> int",
         [](VM* vm, ArgsView args){
             // disable gc during step for safety
             auto _lock = vm->heap.gc_scope_lock();
@@ -314,39 +417,23 @@ void PyWorld::_register(VM* vm, PyVar mod, PyVar type){
             int velocity_iterations = CAST(int, args[2]);
             int position_iterations = CAST(int, args[3]);
 
-            auto f = [](VM* vm, b2Body* p, StrName name){
-                while(p != nullptr){
-                    PyObject* body_obj = get_body_object(p);
-                    PyBody& body = body_obj->as<PyBody>();
-                    if(body.with_callback && !body._is_destroyed){
-                        if(body.node_like != vm->None){
-                            vm->call_method(body.node_like, name);
-                        }
-                    }
-                    p = p->GetNext();
-                }
-            };
-
-            DEF_SNAME(on_box2d_pre_step);
-            DEF_SNAME(on_box2d_post_step);
-            f(vm, self.world.GetBodyList(), on_box2d_pre_step);
-            self.world.Step(dt, velocity_iterations, position_iterations);
-            f(vm, self.world.GetBodyList(), on_box2d_post_step);
-
-            // destroy bodies which are marked as destroyed
-            b2Body* p = self.world.GetBodyList();
-            while(p != nullptr){
-                b2Body* next = p->GetNext();
-                PyBody& body = get_body_object(p)->as<PyBody>();
-                if(body._is_destroyed){
-                    body.body->GetWorld()->DestroyBody(body.body);
-                    body.body = nullptr;
-                    body._fixture = nullptr;
-                    body.node_like = nullptr;
-                }
-                p = next;
+            if(self.fixed_dt <= 0){
+                self._substep(vm, dt, velocity_iterations, position_iterations);
+                self.alpha = 1;
+                return VAR(1);
             }
-            return vm->None;
+
+            self.accumulator += dt;
+            int n = 0;
+            while(self.accumulator >= self.fixed_dt && n < self.max_substeps){
+                self._substep(vm, self.fixed_dt, velocity_iterations, position_iterations);
+                self.accumulator -= self.fixed_dt;
+                n++;
+            }
+            // drop the backlog after a spike instead of spiraling into more substeps
+            if(self.accumulator >= self.fixed_dt) self.accumulator = std::fmod(self.accumulator, self.fixed_dt);
+            self.alpha = self.accumulator / self.fixed_dt;
+            return VAR(n);
         });
 
     vm->bind(type, "debug_draw(self, flags: int)", [](VM* vm, ArgsView args){
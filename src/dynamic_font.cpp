@@ -0,0 +1,298 @@
+#include "dynamic_font.hpp"
+#include "appw.hpp"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// imgui_draw.cpp and raylib have their own copies
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+
+namespace ct{
+
+// transparent border around every glyph, for bilinear filtering
+static const int GLYPH_PADDING = 2;
+
+// distance fields extend this many pixels beyond the glyph outline
+static const int SDF_SPREAD = 4;
+static const unsigned char SDF_ON_EDGE = 128;
+// so the spread covers the whole range below `SDF_ON_EDGE`
+static const float SDF_PIXEL_DIST_SCALE = (float)SDF_ON_EDGE / SDF_SPREAD;
+
+static const char GLYPH_CACHE_MAGIC[4] = {'C', 'T', 'G', 'C'};
+static const int GLYPH_CACHE_VERSION = 1;
+
+static std::vector<DynamicFont*> loaded_fonts;
+
+DynamicFont::~DynamicFont(){
+    // the texture is released by `unload()`, the GL context may be gone at this point
+    loaded_fonts.erase(std::remove(loaded_fonts.begin(), loaded_fonts.end(), this), loaded_fonts.end());
+    if(ttf_data != nullptr) UnloadFileData(ttf_data);
+    delete info;
+    delete[] font.glyphs;
+    delete[] font.recs;
+}
+
+DynamicFont* DynamicFont::find(const Font& font){
+    if(font.texture.id == 0) return nullptr;
+    for(DynamicFont* f: loaded_fonts){
+        if(f->font.texture.id == font.texture.id) return f;
+    }
+    return nullptr;
+}
+
+bool DynamicFont::load(const char* path, int font_size, int texture_size, bool sdf){
+    this->sdf = sdf;
+    ttf_data = LoadFileData(path, &ttf_size);
+    if(ttf_data == nullptr) return false;
+    info = new stbtt_fontinfo();
+    if(!stbtt_InitFont(info, ttf_data, stbtt_GetFontOffsetForIndex(ttf_data, 0))) return false;
+
+    scale = stbtt_ScaleForPixelHeight(info, (float)font_size);
+    int font_ascent, font_descent, line_gap;
+    stbtt_GetFontVMetrics(info, &font_ascent, &font_descent, &line_gap);
+    ascent = (int)(font_ascent * scale);
+
+    // a few decorative glyphs have huge boxes, they are clipped instead of growing every cell
+    int x0, y0, x1, y1;
+    stbtt_GetFontBoundingBox(info, &x0, &y0, &x1, &y1);
+    int glyph_max = (int)std::ceil(std::max(x1 - x0, y1 - y0) * scale);
+    glyph_max = std::min(glyph_max, (int)std::ceil(font_size * 1.25f));
+    if(sdf) glyph_max += SDF_SPREAD * 2;
+    cell_size = glyph_max + GLYPH_PADDING * 2;
+    cells_per_row = texture_size / cell_size;
+    int count = cells_per_row * cells_per_row;
+    // printable ASCII is pinned, leave room for at least as many other glyphs
+    if(count < 95 * 2) return false;
+
+    font.baseSize = font_size;
+    font.glyphCount = count;
+    font.glyphPadding = GLYPH_PADDING;
+    font.glyphs = new GlyphInfo[count]();
+    font.recs = new Rectangle[count]();
+    for(int i=0; i<count; i++) font.glyphs[i].value = -1;
+
+    Image image = {
+        RL_CALLOC(texture_size * texture_size * 2, 1),
+        texture_size, texture_size, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA
+    };
+    font.texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+    // glyphs are rasterized larger than they are usually drawn
+    SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+
+    slots.assign(count, GlyphSlot{-1, 0, false});
+    for(int i=count-1; i>=0; i--) free_slots.push_back(i);
+
+    if(sdf){
+        // one file per font file and size, the name does not need to be readable
+        unsigned int hash = 2166136261u;
+        for(const char* p=path; *p; p++) hash = (hash ^ (unsigned char)*p) * 16777619u;
+        char filename[64];
+        snprintf(filename, sizeof(filename), "glyphs_%08x_%d.bin", hash, font_size);
+        std::filesystem::path cache_file(std::string(platform_caches_directory().sv()));
+        cache_file /= filename;
+        cache_path = cache_file.string();
+        _load_cache();
+    }
+    // '?' takes slot 0, `GetGlyphIndex()` falls back to it for glyphs that are not in the texture
+    _rasterize('?', true);
+    for(int c=32; c<127; c++){
+        if(c != '?') _rasterize(c, true);
+    }
+    loaded_fonts.push_back(this);
+    return true;
+}
+
+int DynamicFont::_take_slot(){
+    if(!free_slots.empty()){
+        int index = free_slots.back();
+        free_slots.pop_back();
+        return index;
+    }
+    // glyphs used by the current `prepare()` are never evicted
+    int victim = -1;
+    for(int i=0; i<slots.size(); i++){
+        const GlyphSlot& s = slots[i];
+        if(s.pinned || s.last_used == tick) continue;
+        if(victim == -1 || s.last_used < slots[victim].last_used) victim = i;
+    }
+    if(victim == -1) return -1;
+    // text drawn earlier in the frame may still have quads of the victim in the render batch,
+    // draw them before its cell is overwritten
+    rlDrawRenderBatchActive();
+    slot_of.erase(slots[victim].codepoint);
+    font.glyphs[victim].value = -1;
+    evictions++;
+    generation++;
+    return victim;
+}
+
+const GlyphImage& DynamicFont::_glyph_image(int codepoint, GlyphImage& tmp){
+    auto it = cached_glyphs.find(codepoint);
+    if(it != cached_glyphs.end()) return it->second;
+
+    int advance, lsb;
+    stbtt_GetCodepointHMetrics(info, codepoint, &advance, &lsb);
+    tmp.advance = (int)(advance * scale);
+    tmp.width = tmp.height = tmp.offset_x = tmp.offset_y = 0;
+    tmp.alpha.clear();
+    if(sdf){
+        // the bitmap includes the spread, so the offsets do too
+        int w, h, xoff, yoff;
+        unsigned char* data = stbtt_GetCodepointSDF(info, scale, codepoint, SDF_SPREAD, SDF_ON_EDGE, SDF_PIXEL_DIST_SCALE, &w, &h, &xoff, &yoff);
+        if(data != nullptr){
+            tmp.width = w;
+            tmp.height = h;
+            tmp.offset_x = xoff;
+            tmp.offset_y = yoff;
+            tmp.alpha.assign(data, data + w * h);
+            stbtt_FreeSDF(data, nullptr);
+        }
+    }else{
+        int x0, y0, x1, y1;
+        stbtt_GetCodepointBitmapBox(info, codepoint, scale, scale, &x0, &y0, &x1, &y1);
+        if(x1 > x0 && y1 > y0){
+            tmp.width = x1 - x0;
+            tmp.height = y1 - y0;
+            tmp.offset_x = x0;
+            tmp.offset_y = y0;
+            tmp.alpha.resize(tmp.width * tmp.height);
+            stbtt_MakeCodepointBitmap(info, tmp.alpha.data(), tmp.width, tmp.height, tmp.width, scale, scale, codepoint);
+        }
+    }
+    if(cache_path.empty()) return tmp;
+    cache_dirty = true;
+    return cached_glyphs[codepoint] = std::move(tmp);
+}
+
+void DynamicFont::_rasterize(int codepoint, bool pinned){
+    int index = _take_slot();
+    if(index == -1) return;     // drawn as '?'
+    int cx = (index % cells_per_row) * cell_size;
+    int cy = (index / cells_per_row) * cell_size;
+
+    GlyphImage tmp;
+    const GlyphImage& image = _glyph_image(codepoint, tmp);
+    int max_size = cell_size - GLYPH_PADDING * 2;
+    int w = std::min(image.width, max_size);
+    int h = std::min(image.height, max_size);
+
+    // the whole cell is uploaded, so nothing of an evicted glyph is left
+    std::vector<unsigned char> pixels(cell_size * cell_size * 2, 0);
+    for(int y=0; y<h; y++){
+        for(int x=0; x<w; x++){
+            int i = ((y + GLYPH_PADDING) * cell_size + x + GLYPH_PADDING) * 2;
+            pixels[i] = 255;
+            pixels[i + 1] = image.alpha[y * image.width + x];
+        }
+    }
+    UpdateTextureRec(font.texture, Rectangle{(float)cx, (float)cy, (float)cell_size, (float)cell_size}, pixels.data());
+
+    GlyphInfo& g = font.glyphs[index];
+    g.value = codepoint;
+    g.offsetX = image.offset_x;
+    g.offsetY = image.offset_y + ascent;
+    g.advanceX = image.advance;
+    font.recs[index] = Rectangle{(float)(cx + GLYPH_PADDING), (float)(cy + GLYPH_PADDING), (float)w, (float)h};
+
+    slots[index] = GlyphSlot{codepoint, tick, pinned};
+    slot_of[codepoint] = index;
+}
+
+void DynamicFont::prepare(std::string_view text){
+    if(font.texture.id == 0) return;
+    tick++;
+    int i = 0;
+    while(i < text.size()){
+        int count = 0;
+        int codepoint = GetCodepoint(text.data() + i, &count);
+        i += std::max(count, 1);
+        if(codepoint < 32) continue;
+
+        auto it = slot_of.find(codepoint);
+        if(it != slot_of.end()){
+            if(it->second >= 0) slots[it->second].last_used = tick;
+            continue;
+        }
+        if(stbtt_FindGlyphIndex(info, codepoint) == 0){
+            // not in the font, remember it so it is not looked up again
+            slot_of[codepoint] = -1;
+            continue;
+        }
+        _rasterize(codepoint, false);
+    }
+}
+
+float DynamicFont::sdf_smoothing(float font_size) const{
+    if(!sdf || font_size <= 0) return 0.0f;
+    // the distance changes by `SDF_PIXEL_DIST_SCALE / 255` per texel, a screen pixel is `baseSize / font_size` texels
+    float per_pixel = SDF_PIXEL_DIST_SCALE / 255.0f * font.baseSize / font_size;
+    return std::min(per_pixel * 0.5f, 0.5f);
+}
+
+// header: magic, version, font size, font file size
+// then per glyph: codepoint, width, height, offset_x, offset_y, advance and `width * height` bytes
+void DynamicFont::_load_cache(){
+    FILE* fp = fopen(cache_path.c_str(), "rb");
+    if(fp == nullptr) return;
+    char magic[4];
+    int header[3];
+    bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, GLYPH_CACHE_MAGIC, 4) == 0;
+    ok = ok && fread(header, sizeof(int), 3, fp) == 3;
+    ok = ok && header[0] == GLYPH_CACHE_VERSION && header[1] == font.baseSize && header[2] == ttf_size;
+    int record[6];
+    while(ok && fread(record, sizeof(int), 6, fp) == 6){
+        int w = record[1], h = record[2];
+        if(w < 0 || h < 0 || w > cell_size * 4 || h > cell_size * 4) break;
+        GlyphImage image{w, h, record[3], record[4], record[5], std::vector<unsigned char>(w * h)};
+        if(fread(image.alpha.data(), 1, image.alpha.size(), fp) != image.alpha.size()) break;
+        cached_glyphs[record[0]] = std::move(image);
+    }
+    fclose(fp);
+    cache_dirty = false;
+}
+
+bool DynamicFont::save_cache(){
+    if(cache_path.empty() || !cache_dirty) return true;
+    FILE* fp = fopen(cache_path.c_str(), "wb");
+    if(fp == nullptr){
+        platform_log_error(Str("failed to write glyph cache " + cache_path));
+        return false;
+    }
+    int header[3] = {GLYPH_CACHE_VERSION, font.baseSize, ttf_size};
+    fwrite(GLYPH_CACHE_MAGIC, 1, 4, fp);
+    fwrite(header, sizeof(int), 3, fp);
+    for(auto& [codepoint, image]: cached_glyphs){
+        int record[6] = {codepoint, image.width, image.height, image.offset_x, image.offset_y, image.advance};
+        fwrite(record, sizeof(int), 6, fp);
+        fwrite(image.alpha.data(), 1, image.alpha.size(), fp);
+    }
+    fclose(fp);
+    cache_dirty = false;
+    return true;
+}
+
+void DynamicFont::unload(){
+    save_cache();
+    loaded_fonts.erase(std::remove(loaded_fonts.begin(), loaded_fonts.end(), this), loaded_fonts.end());
+    if(font.texture.id != 0) UnloadTexture(font.texture);
+    if(ttf_data != nullptr) UnloadFileData(ttf_data);
+    delete info;
+    delete[] font.glyphs;
+    delete[] font.recs;
+    font = Font{};
+    ttf_data = nullptr;
+    info = nullptr;
+    slots.clear();
+    slot_of.clear();
+    free_slots.clear();
+    cached_glyphs.clear();
+    cache_path.clear();
+}
+
+}   // namespace ct
@@ -1,4 +1,9 @@
 #include "light.hpp"
+#include "thread_pool.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
 
 namespace aseprite{
 
@@ -150,6 +155,199 @@ void algo_ellipsefill(int x0, int y0, int x1, int y1,
 
 
 namespace ct{
+
+static void check_light_formats(Image* img, Image* cookie){
+    if(img->format != PIXELFORMAT_UNCOMPRESSED_R32G32B32A32){
+        throw std::runtime_error("img->format != PIXELFORMAT_UNCOMPRESSED_R32G32B32A32");
+    }
+    if(cookie && cookie->format != PIXELFORMAT_UNCOMPRESSED_GRAYSCALE){
+        throw std::runtime_error("cookie->format != PIXELFORMAT_UNCOMPRESSED_GRAYSCALE");
+    }
+}
+
+static void kernel_color(float out[4], Color color, double intensity){
+    HdrColor c(color, intensity);
+    out[0] = c.r;
+    out[1] = c.g;
+    out[2] = c.b;
+    // `HdrColor::additive()` clamps the alpha
+    out[3] = std::clamp(c.a, 0.0f, 1.0f);
+}
+
+// light the texels of `region`, which is inside the image, `y` is already flipped
+static void bake_point_region(Image* img, const float c[4], int x, int y, int r, Image* cookie, const LightRect& region){
+    int row_begin = region.y, row_end = region.y + region.height;
+    // (i, j) is the texel in the light's square of 2r+1 texels, clipped to the region
+    int i_begin = std::max(0, region.x - x + r);
+    int i_end = std::min(2 * r, region.x + region.width - 1 - x + r);
+    int j_begin = std::max(0, row_begin - y + r);
+    int j_end = std::min(2 * r, row_end - 1 - y + r);
+    if(i_begin > i_end || j_begin > j_end) return;
+    int n = i_end - i_begin + 1;
+
+    const LightKernels& kernels = get_light_kernels();
+    // reused between calls, so baking does not allocate
+    thread_local std::vector<float> base;
+    thread_local std::vector<int> cookie_u;
+    base.resize(n);
+
+    if(cookie){
+        cookie_u.resize(n);
+        for(int k=0; k<n; k++){
+            double u = (i_begin + k) / (2.0 * r);
+            cookie_u[k] = std::clamp((int)(u * (cookie->width - 1)), 0, cookie->width - 1);
+        }
+        const unsigned char* mask = (const unsigned char*)cookie->data;
+        for(int j=j_begin; j<=j_end; j++){
+            double v = j / (2.0 * r);
+            int v_offset = std::clamp((int)(v * (cookie->height - 1)), 0, cookie->height - 1);
+            const unsigned char* row = mask + cookie->width * v_offset;
+            for(int k=0; k<n; k++) base[k] = row[cookie_u[k]] / 255.0f;
+            HdrColor* dst = (HdrColor*)img->data + img->width * (y - r + j) + (x - r + i_begin);
+            kernels.accumulate_row(dst, base.data(), 0.0f, n, c);
+        }
+    }else{
+        // quadratic attenuation 1 - d^2/r^2 is separable, the x part is computed once per light
+        float inv_r2 = 1.0f / ((float)r * r);
+        for(int k=0; k<n; k++){
+            int dx = i_begin + k - r;
+            base[k] = 1.0f - dx * dx * inv_r2;
+        }
+        for(int j=j_begin; j<=j_end; j++){
+            int dy = j - r;
+            HdrColor* dst = (HdrColor*)img->data + img->width * (y - r + j) + (x - r + i_begin);
+            kernels.accumulate_row(dst, base.data(), dy * dy * inv_r2, n, c);
+        }
+    }
+}
+
+void bake_global_light(Image* img, Color color, double intensity){
+    check_light_formats(img, nullptr);
+    float c[4];
+    kernel_color(c, color, intensity);
+    get_light_kernels().add_constant((HdrColor*)img->data, img->width * img->height, c);
+}
+
+void bake_point_light(Image* img, Color color, double intensity, int x, int y, int r, Image* cookie){
+    check_light_formats(img, cookie);
+    if(r <= 0) return;
+    float c[4];
+    kernel_color(c, color, intensity);
+    bake_point_region(img, c, x, img->height - y - 1, r, cookie, LightRect{0, 0, img->width, img->height});
+}
+
+LightBakeItem LightBakeItem::global(Color color, double intensity){
+    LightBakeItem item = {};
+    kernel_color(item.color, color, intensity);
+    item.is_global = true;
+    return item;
+}
+
+LightBakeItem LightBakeItem::point(Color color, double intensity, int x, int y, int r, Image* cookie){
+    LightBakeItem item = {};
+    kernel_color(item.color, color, intensity);
+    item.x = x;
+    item.y = y;
+    item.r = r;
+    item.cookie = cookie;
+    return item;
+}
+
+LightRect LightBakeItem::rect(const Image* img) const{
+    LightRect image_rect = {0, 0, img->width, img->height};
+    if(is_global) return image_rect;
+    if(r <= 0) return LightRect{0, 0, 0, 0};
+    int y_flipped = img->height - y - 1;
+    return LightRect{x - r, y_flipped - r, 2 * r + 1, 2 * r + 1}.intersect(image_rect);
+}
+
+bool LightBakeItem::operator==(const LightBakeItem& other) const{
+    return std::equal(color, color + 4, other.color) && is_global == other.is_global &&
+        x == other.x && y == other.y && r == other.r &&
+        cookie == other.cookie && cookie_texture == other.cookie_texture;
+}
+
+void bake_lights(Image* img, const std::vector<LightBakeItem>& lights){
+    bake_lights(img, lights, LightRect{0, 0, img->width, img->height});
+}
+
+void bake_lights(Image* img, const std::vector<LightBakeItem>& lights, LightRect region){
+    check_light_formats(img, nullptr);
+    for(const LightBakeItem& light: lights) check_light_formats(img, light.cookie);
+    region = region.intersect(LightRect{0, 0, img->width, img->height});
+    if(region.empty()) return;
+
+    ThreadPool& pool = get_thread_pool();
+    // a few bands per thread, so uneven bands (lights are not spread evenly) balance out
+    const int MIN_BAND_ROWS = 16;
+    int band_count = std::clamp(region.height / MIN_BAND_ROWS, 1, pool.thread_count() * 4);
+    int band_rows = (region.height + band_count - 1) / band_count;
+    band_count = (region.height + band_rows - 1) / band_rows;
+
+    const LightKernels& kernels = get_light_kernels();
+    pool.parallel_for(band_count, [&](int band){
+        int row_begin = region.y + band * band_rows;
+        int row_end = std::min(row_begin + band_rows, region.y + region.height);
+        LightRect band_rect = {region.x, row_begin, region.width, row_end - row_begin};
+        // rows of the band are contiguous if it spans the image width
+        bool contiguous = region.width == img->width;
+        int segment_count = contiguous ? 1 : band_rect.height;
+        int segment_size = contiguous ? band_rect.width * band_rect.height : band_rect.width;
+        auto segment = [&](int k){
+            return (HdrColor*)img->data + img->width * (row_begin + k) + region.x;
+        };
+        // same as clearing to opaque black
+        for(int k=0; k<segment_count; k++){
+            HdrColor* dst = segment(k);
+            for(int i=0; i<segment_size; i++) dst[i] = HdrColor(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        // every texel sees the same lights in the same order as a single-threaded bake
+        for(const LightBakeItem& light: lights){
+            if(light.is_global){
+                for(int k=0; k<segment_count; k++) kernels.add_constant(segment(k), segment_size, light.color);
+            }else if(light.r > 0){
+                bake_point_region(img, light.color, light.x, img->height - light.y - 1, light.r, light.cookie, band_rect);
+            }
+        }
+    });
+}
+
+void encode_rgbm(const HdrColor* src, int n, Color* dst, float range){
+    for(int i=0; i<n; i++){
+        const HdrColor& c = src[i];
+        float peak = std::max(c.r, std::max(c.g, c.b));
+        // rounded up, so rgb / m stays in range
+        float m = std::ceil(std::clamp(peak / range, 0.0f, 1.0f) * 255.0f) / 255.0f;
+        if(m <= 0.0f){
+            dst[i] = Color{0, 0, 0, 0};
+            continue;
+        }
+        float k = 255.0f / (m * range);
+        dst[i] = Color{
+            (unsigned char)std::min(c.r * k + 0.5f, 255.0f),
+            (unsigned char)std::min(c.g * k + 0.5f, 255.0f),
+            (unsigned char)std::min(c.b * k + 0.5f, 255.0f),
+            (unsigned char)(m * 255.0f + 0.5f)
+        };
+    }
+}
+
+Image gen_light_falloff(int size){
+    Image img = {RL_MALLOC(size * size), size, size, 1, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+    unsigned char* data = (unsigned char*)img.data;
+    for(int j=0; j<size; j++){
+        for(int i=0; i<size; i++){
+            // texel centers mapped to [-1, 1], 1 - d^2/r^2 like `bake_point_light()`
+            float u = (i + 0.5f) / size * 2.0f - 1.0f;
+            float v = (j + 0.5f) / size * 2.0f - 1.0f;
+            float base = std::max(1.0f - (u * u + v * v), 0.0f);
+            data[j * size + i] = (unsigned char)(base * 255.0f + 0.5f);
+        }
+    }
+    return img;
+}
+
+namespace reference{
     void bake_global_light(Image* img, Color color, double intensity){
         if(img->format != PIXELFORMAT_UNCOMPRESSED_R32G32B32A32){
             throw std::runtime_error("img->format != PIXELFORMAT_UNCOMPRESSED_R32G32B32A32");
@@ -193,4 +391,57 @@ namespace ct{
           }
         }
     }
-}
\ No newline at end of file
+
+    static float max_abs_diff(const Image& a, const Image& b){
+        const float* pa = (const float*)a.data;
+        const float* pb = (const float*)b.data;
+        float diff = 0.0f;
+        for(int i=0; i<a.width * a.height * 4; i++) diff = std::max(diff, std::abs(pa[i] - pb[i]));
+        return diff;
+    }
+
+    float check_kernels(){
+        const int W = 67, H = 45;   // odd sizes leave tails for every vector width
+        Image a = {RL_MALLOC(W * H * sizeof(HdrColor)), W, H, 1, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32};
+        Image b = {RL_MALLOC(W * H * sizeof(HdrColor)), W, H, 1, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32};
+        float* pa = (float*)a.data;
+        for(int i=0; i<W * H * 4; i++) pa[i] = (float)((i * 37) % 101) / 404.0f;
+        memcpy(b.data, a.data, W * H * sizeof(HdrColor));
+
+        // a non-square cookie with a pattern, so a wrong lookup shows up
+        const int CW = 13, CH = 9;
+        Image cookie = {RL_MALLOC(CW * CH), CW, CH, 1, PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+        for(int i=0; i<CW * CH; i++) ((unsigned char*)cookie.data)[i] = (unsigned char)((i * 53) % 256);
+
+        struct Case{ int x, y, r; bool cookie; };
+        const Case cases[] = {
+            {33, 22, 10, false},    // inside
+            {33, 22, 40, false},    // larger than the image
+            {-3, 2, 7, false},      // clipped at the corners
+            {W - 2, H + 3, 9, false},
+            {-20, 10, 5, false},    // fully outside
+            {5, 40, 1, false},
+            {30, 20, 12, true},
+            {-4, -4, 11, true},
+            {W + 2, 20, 6, true},
+            {20, H - 1, 3, true},
+        };
+        Color color = {255, 180, 64, 200};
+
+        reference::bake_global_light(&a, color, 0.25);
+        ct::bake_global_light(&b, color, 0.25);
+        float diff = max_abs_diff(a, b);
+        for(const Case& c : cases){
+            Image* ck = c.cookie ? &cookie : nullptr;
+            reference::bake_point_light(&a, color, 0.75, c.x, c.y, c.r, ck);
+            ct::bake_point_light(&b, color, 0.75, c.x, c.y, c.r, ck);
+            diff = std::max(diff, max_abs_diff(a, b));
+        }
+        UnloadImage(a);
+        UnloadImage(b);
+        UnloadImage(cookie);
+        return diff;
+    }
+}   // namespace reference
+
+}   // namespace ct
@@ -0,0 +1,193 @@
+#include "light.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CT_LIGHT_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled with a target attribute and only used if the cpu supports it
+#if defined(CT_LIGHT_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CT_LIGHT_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define CT_LIGHT_NEON
+#include <arm_neon.h>
+#endif
+
+// all kernels compute `(dst & rgb_mask) + (color * att + alpha)`, with alpha only in the last lane
+// adding zero is exact, so they round like the scalar kernel, unless the compiler fuses its multiply-add
+
+namespace ct{
+
+static void accumulate_row_scalar(HdrColor* dst, const float* base, float offset, int n, const float color[4]){
+    for(int i=0; i<n; i++){
+        float att = std::max(base[i] - offset, 0.0f);
+        dst[i].r += color[0] * att;
+        dst[i].g += color[1] * att;
+        dst[i].b += color[2] * att;
+        dst[i].a = color[3];
+    }
+}
+
+static void add_constant_scalar(HdrColor* dst, int n, const float color[4]){
+    for(int i=0; i<n; i++){
+        dst[i].r += color[0];
+        dst[i].g += color[1];
+        dst[i].b += color[2];
+        dst[i].a = color[3];
+    }
+}
+
+#ifdef CT_LIGHT_SSE2
+// one texel per register, four texels per iteration
+static void accumulate_row_sse2(HdrColor* dst, const float* base, float offset, int n, const float color[4]){
+    float* p = (float*)dst;
+    const __m128 rgb = _mm_set_ps(0.0f, color[2], color[1], color[0]);
+    const __m128 alpha = _mm_set_ps(color[3], 0.0f, 0.0f, 0.0f);
+    const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 off = _mm_set1_ps(offset);
+    const __m128 zero = _mm_setzero_ps();
+    int i = 0;
+    for(; i+4<=n; i+=4){
+        __m128 att = _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(base + i), off), zero);
+        __m128 a0 = _mm_shuffle_ps(att, att, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 a1 = _mm_shuffle_ps(att, att, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 a2 = _mm_shuffle_ps(att, att, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 a3 = _mm_shuffle_ps(att, att, _MM_SHUFFLE(3, 3, 3, 3));
+        float* q = p + i * 4;
+        _mm_storeu_ps(q + 0,  _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 0),  rgb_mask), _mm_add_ps(_mm_mul_ps(rgb, a0), alpha)));
+        _mm_storeu_ps(q + 4,  _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 4),  rgb_mask), _mm_add_ps(_mm_mul_ps(rgb, a1), alpha)));
+        _mm_storeu_ps(q + 8,  _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 8),  rgb_mask), _mm_add_ps(_mm_mul_ps(rgb, a2), alpha)));
+        _mm_storeu_ps(q + 12, _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 12), rgb_mask), _mm_add_ps(_mm_mul_ps(rgb, a3), alpha)));
+    }
+    accumulate_row_scalar(dst + i, base + i, offset, n - i, color);
+}
+
+static void add_constant_sse2(HdrColor* dst, int n, const float color[4]){
+    float* p = (float*)dst;
+    const __m128 c = _mm_set_ps(color[3], color[2], color[1], color[0]);
+    const __m128 rgb_mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    int i = 0;
+    for(; i+4<=n; i+=4){
+        float* q = p + i * 4;
+        _mm_storeu_ps(q + 0,  _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 0),  rgb_mask), c));
+        _mm_storeu_ps(q + 4,  _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 4),  rgb_mask), c));
+        _mm_storeu_ps(q + 8,  _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 8),  rgb_mask), c));
+        _mm_storeu_ps(q + 12, _mm_add_ps(_mm_and_ps(_mm_loadu_ps(q + 12), rgb_mask), c));
+    }
+    add_constant_scalar(dst + i, n - i, color);
+}
+#endif
+
+#ifdef CT_LIGHT_AVX2
+// two texels per register, eight texels per iteration
+__attribute__((target("avx2")))
+static void accumulate_row_avx2(HdrColor* dst, const float* base, float offset, int n, const float color[4]){
+    float* p = (float*)dst;
+    const __m256 rgb = _mm256_set_ps(0.0f, color[2], color[1], color[0], 0.0f, color[2], color[1], color[0]);
+    const __m256 alpha = _mm256_set_ps(color[3], 0.0f, 0.0f, 0.0f, color[3], 0.0f, 0.0f, 0.0f);
+    const __m256 rgb_mask = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+    const __m256 off = _mm256_set1_ps(offset);
+    const __m256 zero = _mm256_setzero_ps();
+    // attenuation of texels (2k, 2k+1) spread over their lanes
+    const __m256i spread0 = _mm256_set_epi32(1, 1, 1, 1, 0, 0, 0, 0);
+    const __m256i spread1 = _mm256_set_epi32(3, 3, 3, 3, 2, 2, 2, 2);
+    const __m256i spread2 = _mm256_set_epi32(5, 5, 5, 5, 4, 4, 4, 4);
+    const __m256i spread3 = _mm256_set_epi32(7, 7, 7, 7, 6, 6, 6, 6);
+    int i = 0;
+    for(; i+8<=n; i+=8){
+        __m256 att = _mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(base + i), off), zero);
+        float* q = p + i * 4;
+        _mm256_storeu_ps(q + 0,  _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 0),  rgb_mask), _mm256_add_ps(_mm256_mul_ps(rgb, _mm256_permutevar8x32_ps(att, spread0)), alpha)));
+        _mm256_storeu_ps(q + 8,  _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 8),  rgb_mask), _mm256_add_ps(_mm256_mul_ps(rgb, _mm256_permutevar8x32_ps(att, spread1)), alpha)));
+        _mm256_storeu_ps(q + 16, _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 16), rgb_mask), _mm256_add_ps(_mm256_mul_ps(rgb, _mm256_permutevar8x32_ps(att, spread2)), alpha)));
+        _mm256_storeu_ps(q + 24, _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 24), rgb_mask), _mm256_add_ps(_mm256_mul_ps(rgb, _mm256_permutevar8x32_ps(att, spread3)), alpha)));
+    }
+    accumulate_row_sse2(dst + i, base + i, offset, n - i, color);
+}
+
+__attribute__((target("avx2")))
+static void add_constant_avx2(HdrColor* dst, int n, const float color[4]){
+    float* p = (float*)dst;
+    const __m256 c = _mm256_set_ps(color[3], color[2], color[1], color[0], color[3], color[2], color[1], color[0]);
+    const __m256 rgb_mask = _mm256_castsi256_ps(_mm256_set_epi32(0, -1, -1, -1, 0, -1, -1, -1));
+    int i = 0;
+    for(; i+8<=n; i+=8){
+        float* q = p + i * 4;
+        _mm256_storeu_ps(q + 0,  _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 0),  rgb_mask), c));
+        _mm256_storeu_ps(q + 8,  _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 8),  rgb_mask), c));
+        _mm256_storeu_ps(q + 16, _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 16), rgb_mask), c));
+        _mm256_storeu_ps(q + 24, _mm256_add_ps(_mm256_and_ps(_mm256_loadu_ps(q + 24), rgb_mask), c));
+    }
+    add_constant_sse2(dst + i, n - i, color);
+}
+#endif
+
+#ifdef CT_LIGHT_NEON
+// one texel per register, four texels per iteration
+static inline float32x4_t neon_blend(float* q, uint32x4_t rgb_mask, float32x4_t add){
+    float32x4_t px = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(vld1q_f32(q)), rgb_mask));
+    return vaddq_f32(px, add);
+}
+
+static void accumulate_row_neon(HdrColor* dst, const float* base, float offset, int n, const float color[4]){
+    float* p = (float*)dst;
+    const float rgb_values[4] = {color[0], color[1], color[2], 0.0f};
+    const float alpha_values[4] = {0.0f, 0.0f, 0.0f, color[3]};
+    const uint32_t mask_values[4] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0u};
+    const float32x4_t rgb = vld1q_f32(rgb_values);
+    const float32x4_t alpha = vld1q_f32(alpha_values);
+    const uint32x4_t rgb_mask = vld1q_u32(mask_values);
+    const float32x4_t off = vdupq_n_f32(offset);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    int i = 0;
+    for(; i+4<=n; i+=4){
+        float32x4_t att = vmaxq_f32(vsubq_f32(vld1q_f32(base + i), off), zero);
+        float* q = p + i * 4;
+        // separate multiply and add, a fused multiply-add would round differently
+        vst1q_f32(q + 0,  neon_blend(q + 0,  rgb_mask, vaddq_f32(vmulq_n_f32(rgb, vgetq_lane_f32(att, 0)), alpha)));
+        vst1q_f32(q + 4,  neon_blend(q + 4,  rgb_mask, vaddq_f32(vmulq_n_f32(rgb, vgetq_lane_f32(att, 1)), alpha)));
+        vst1q_f32(q + 8,  neon_blend(q + 8,  rgb_mask, vaddq_f32(vmulq_n_f32(rgb, vgetq_lane_f32(att, 2)), alpha)));
+        vst1q_f32(q + 12, neon_blend(q + 12, rgb_mask, vaddq_f32(vmulq_n_f32(rgb, vgetq_lane_f32(att, 3)), alpha)));
+    }
+    accumulate_row_scalar(dst + i, base + i, offset, n - i, color);
+}
+
+static void add_constant_neon(HdrColor* dst, int n, const float color[4]){
+    float* p = (float*)dst;
+    const uint32_t mask_values[4] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0u};
+    const float32x4_t c = vld1q_f32(color);
+    const uint32x4_t rgb_mask = vld1q_u32(mask_values);
+    int i = 0;
+    for(; i+4<=n; i+=4){
+        float* q = p + i * 4;
+        vst1q_f32(q + 0,  neon_blend(q + 0,  rgb_mask, c));
+        vst1q_f32(q + 4,  neon_blend(q + 4,  rgb_mask, c));
+        vst1q_f32(q + 8,  neon_blend(q + 8,  rgb_mask, c));
+        vst1q_f32(q + 12, neon_blend(q + 12, rgb_mask, c));
+    }
+    add_constant_scalar(dst + i, n - i, color);
+}
+#endif
+
+static LightKernels select_light_kernels(){
+#if defined(CT_LIGHT_AVX2)
+    if(__builtin_cpu_supports("avx2")) return LightKernels{"avx2", accumulate_row_avx2, add_constant_avx2};
+#endif
+#if defined(CT_LIGHT_SSE2)
+    return LightKernels{"sse2", accumulate_row_sse2, add_constant_sse2};
+#elif defined(CT_LIGHT_NEON)
+    return LightKernels{"neon", accumulate_row_neon, add_constant_neon};
+#else
+    return LightKernels{"scalar", accumulate_row_scalar, add_constant_scalar};
+#endif
+}
+
+const LightKernels& get_light_kernels(){
+    static const LightKernels kernels = select_light_kernels();
+    return kernels;
+}
+
+}   // namespace ct
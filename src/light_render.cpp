@@ -0,0 +1,100 @@
+#include "light.hpp"
+#include "rlgl.h"
+
+#include <cmath>
+
+namespace ct{
+
+static RenderTexture2D try_load_light_target(int width, int height, int format){
+    RenderTexture2D target = {};
+    target.id = rlLoadFramebuffer(width, height);
+    if(target.id == 0) return target;
+    rlEnableFramebuffer(target.id);
+    target.texture.id = rlLoadTexture(NULL, width, height, format, 1);
+    target.texture.width = width;
+    target.texture.height = height;
+    target.texture.format = format;
+    target.texture.mipmaps = 1;
+    // no depth buffer, lights are drawn in order
+    rlFramebufferAttach(target.id, target.texture.id, RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D, 0);
+    bool ok = rlFramebufferComplete(target.id);
+    rlDisableFramebuffer();
+    if(!ok){
+        UnloadRenderTexture(target);
+        return RenderTexture2D{};
+    }
+    return target;
+}
+
+RenderTexture2D load_light_target(int width, int height){
+#if defined(GRAPHICS_API_OPENGL_33)
+    RenderTexture2D target = try_load_light_target(width, height, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+    if(target.id != 0) return target;
+    TraceLog(LOG_WARNING, "LIGHT: floating point render textures are not supported, lights saturate at 1.0");
+#endif
+    // float color buffers are an extension on GLES
+    return try_load_light_target(width, height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+}
+
+void render_lights(RenderTexture2D target, Texture2D falloff, const std::vector<LightBakeItem>& lights){
+    // vertex colors are 8 bit, brighter lights are split into passes of at most 1.0
+    const int MAX_PASSES = 16;
+
+    BeginTextureMode(target);
+    ClearBackground(BLACK);
+    // rgb is accumulated and alpha is replaced, like `HdrColor::additive()`
+    rlSetBlendFactorsSeparate(RL_ONE, RL_ONE, RL_ONE, RL_ZERO, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+
+    for(const LightBakeItem& light: lights){
+        float x0, y0, x1, y1;
+        unsigned int texture;
+        if(light.is_global){
+            x0 = 0; y0 = 0;
+            x1 = (float)target.texture.width;
+            y1 = (float)target.texture.height;
+            texture = rlGetTextureIdDefault();
+        }else{
+            if(light.r <= 0) continue;
+            // the square of 2r+1 texels of `bake_point_light()`
+            x0 = (float)(light.x - light.r);
+            y0 = (float)(light.y - light.r);
+            x1 = (float)(light.x + light.r + 1);
+            y1 = (float)(light.y + light.r + 1);
+            texture = light.cookie_texture != 0 ? light.cookie_texture : falloff.id;
+        }
+
+        float peak = std::max(light.color[0], std::max(light.color[1], light.color[2]));
+        int passes = std::clamp((int)std::ceil(peak), 1, MAX_PASSES);
+        float scale = 255.0f / passes;
+        Color c = {
+            (unsigned char)std::clamp(light.color[0] * scale + 0.5f, 0.0f, 255.0f),
+            (unsigned char)std::clamp(light.color[1] * scale + 0.5f, 0.0f, 255.0f),
+            (unsigned char)std::clamp(light.color[2] * scale + 0.5f, 0.0f, 255.0f),
+            (unsigned char)(light.color[3] * 255.0f + 0.5f)
+        };
+
+        rlSetTexture(texture);
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        for(int p=0; p<passes; p++){
+            // the first row of a cookie is at the bottom of the square, as in `bake_point_light()`
+            rlColor4ub(c.r, c.g, c.b, c.a);
+            rlTexCoord2f(0.0f, 1.0f);
+            rlVertex2f(x0, y0);
+            rlTexCoord2f(0.0f, 0.0f);
+            rlVertex2f(x0, y1);
+            rlTexCoord2f(1.0f, 0.0f);
+            rlVertex2f(x1, y1);
+            rlTexCoord2f(1.0f, 1.0f);
+            rlVertex2f(x1, y0);
+        }
+        rlEnd();
+    }
+    rlSetTexture(0);
+
+    EndBlendMode();
+    EndTextureMode();
+}
+
+}   // namespace ct
@@ -0,0 +1,71 @@
+#include "lightmap.hpp"
+
+namespace ct{
+
+// a texel needs baking if the lights covering it changed, lights are compared by their index
+// so that the order of the lights, which decides the alpha, is taken into account
+LightRect LightmapBaker::_dirty_rect(const Image* img, const std::vector<LightBakeItem>& lights) const{
+    if(img->width != width || img->height != height) return LightRect{0, 0, img->width, img->height};
+    LightRect dirty = {0, 0, 0, 0};
+    size_t n = std::max(lights.size(), previous.size());
+    for(size_t i=0; i<n; i++){
+        if(i >= lights.size()){
+            dirty = dirty.merge(previous[i].rect(img));
+        }else if(i >= previous.size()){
+            dirty = dirty.merge(lights[i].rect(img));
+        }else if(lights[i] != previous[i]){
+            dirty = dirty.merge(lights[i].rect(img));
+            dirty = dirty.merge(previous[i].rect(img));
+        }
+    }
+    return dirty;
+}
+
+bool LightmapBaker::bake(Image* img, Texture2D texture, std::vector<LightBakeItem>&& lights){
+    LightRect dirty = _dirty_rect(img, lights);
+    previous = std::move(lights);
+    width = img->width;
+    height = img->height;
+    dirty_texels = dirty.empty() ? 0 : dirty.width * dirty.height;
+    if(dirty.empty()) return false;
+
+    bake_lights(img, previous, dirty);
+    Rectangle rec = {(float)dirty.x, (float)dirty.y, (float)dirty.width, (float)dirty.height};
+    if(rgbm_range > 0.0f){
+        thread_local std::vector<Color> encoded;
+        encoded.resize(dirty_texels);
+        for(int j=0; j<dirty.height; j++){
+            const HdrColor* row = (const HdrColor*)img->data + img->width * (dirty.y + j) + dirty.x;
+            encode_rgbm(row, dirty.width, encoded.data() + dirty.width * j, rgbm_range);
+        }
+        UpdateTextureRec(texture, rec, encoded.data());
+        return true;
+    }
+    if(dirty.width == img->width && dirty.height == img->height){
+        UpdateTexture(texture, img->data);
+        return true;
+    }
+    // `UpdateTextureRec()` takes tightly packed rows
+    thread_local std::vector<HdrColor> pixels;
+    pixels.clear();
+    pixels.reserve(dirty_texels);
+    for(int j=0; j<dirty.height; j++){
+        const HdrColor* row = (const HdrColor*)img->data + img->width * (dirty.y + j) + dirty.x;
+        pixels.insert(pixels.end(), row, row + dirty.width);
+    }
+    UpdateTextureRec(texture, rec, pixels.data());
+    return true;
+}
+
+bool LightmapBaker::render(RenderTexture2D target, Texture2D falloff, std::vector<LightBakeItem>&& lights){
+    bool changed = target.texture.width != width || target.texture.height != height || lights != previous;
+    previous = std::move(lights);
+    width = target.texture.width;
+    height = target.texture.height;
+    dirty_texels = changed ? width * height : 0;
+    if(!changed) return false;
+    render_lights(target, falloff, previous);
+    return true;
+}
+
+}   // namespace ct
@@ -1,6 +1,13 @@
 #include "appw.hpp"
+#include "profiler.hpp"
 #include "raylib.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+
 using namespace pkpy;
 using namespace ct;
 
@@ -20,6 +27,29 @@ static std::string error_screen_msg;
 static int main_argc;
 static char** main_argv;
 
+#if CT_BENCHMARK
+// headless benchmark state, the game sees a fixed frame time
+static double bench_dt = 1.0 / 60;
+static i64 bench_frame = 0;
+// arguments after the output path, passed to the project as `sys.argv[1:]`
+static std::vector<char*> bench_argv;
+
+static void bench_patch_modules(VM* vm){
+    // make `rl.GetFrameTime()` and `rl.GetTime()` deterministic
+    PyVar rl = vm->_modules["raylib"];
+    vm->bind(rl, "GetFrameTime() -> float", [](VM* vm, ArgsView args){
+        return VAR((float)bench_dt);
+    });
+    vm->bind(rl, "GetTime() -> float", [](VM* vm, ArgsView args){
+        return VAR(bench_frame * bench_dt);
+    });
+    // same random sequence on every run
+    PyVar random = vm->py_import("random");
+    vm->call(vm->getattr(random, "seed"), VAR(0));
+    vm->set_main_argv(bench_argv.size(), bench_argv.data());
+}
+#endif
+
 // cached objects
 struct _Cached{
     PyVar game = nullptr;
@@ -102,6 +132,10 @@ void ios_ready(){
             return vm->None;
         });
 
+#if CT_BENCHMARK
+    bench_patch_modules(vm);
+#endif
+
 // desktop platforms
 #if PK_IS_DESKTOP_PLATFORM == 1
     if(main_argc > 1){
@@ -183,8 +217,118 @@ void ios_destroy(){
     delete vm;
 }
 
+#if CT_BENCHMARK
+static double percentile(const std::vector<double>& sorted, double p){
+    int i = (int)std::ceil(p * sorted.size()) - 1;
+    return sorted[std::clamp(i, 0, (int)sorted.size() - 1)];
+}
+
+static void write_stats(FILE* fp, const char* name, std::vector<double> values){
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for(double ms: values) sum += ms;
+    fprintf(fp, "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}", name,
+        sum / values.size(), percentile(values, 0.50), percentile(values, 0.95), percentile(values, 0.99), values.back());
+}
+
+// GameBench [project_dir] [template_dir] [frames] [warmup] [dt] [output.json]
+//
+// Runs the game for a fixed number of frames with a fixed frame time in a hidden window,
+// then writes frame-time percentiles and per-phase totals as JSON to `output.json` or stdout.
+//
+// raylib has no null backend, so this needs a real OpenGL context. Without a GPU, run it under
+// `xvfb-run` with mesa's software renderer. `frame_ms` then includes software rasterisation,
+// which mostly happens in the `present` phase, gate regressions on `cpu_frame_ms` or the phases instead.
+int main(int argc, char** argv){
+    if(argc < 3){
+        platform_log_error("Usage: GameBench [project_dir] [template_dir] [frames=600] [warmup=60] [dt=0.016667] [output.json] [args...]\n");
+        return 1;
+    }
+    int frames = argc > 3 ? std::stoi(argv[3]) : 600;
+    int warmup = argc > 4 ? std::stoi(argv[4]) : 60;
+    bench_dt = argc > 5 ? std::stod(argv[5]) : 1.0 / 60;
+    if(frames <= 0 || warmup < 0 || bench_dt <= 0){
+        platform_log_error("Error: frames and dt must be positive, warmup must be non-negative\n");
+        return 1;
+    }
+    // "-" prints the report to stdout
+    const char* output = argc > 6 && std::string_view(argv[6]) != "-" ? argv[6] : nullptr;
+    bench_argv.push_back(argv[0]);
+    for(int i=7; i<argc; i++) bench_argv.push_back(argv[i]);
+
+    main_argc = 3;
+    main_argv = argv;
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    SetTraceLogLevel(LOG_WARNING);
+
+    ios_ready();
+    if(cached.game == nullptr || !error_screen_msg.empty()) return 1;
+
+    std::vector<double> frame_ms;
+    std::vector<double> cpu_frame_ms;       // without the `present` phase, which waits for the GL driver
+    frame_ms.reserve(frames);
+    cpu_frame_ms.reserve(frames);
+    std::map<std::string, double> phase_warmup;
+    for(int i=0; i<warmup+frames; i++){
+        Profiler* profiler = Profiler::current;
+        if(i == warmup && profiler != nullptr){
+            for(const ProfilerPhase& phase: profiler->phases) phase_warmup[phase.name] = phase.total + phase.current;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        ios_update();
+        auto t1 = std::chrono::steady_clock::now();
+        if(!error_screen_msg.empty()) return 1;
+        if(i >= warmup){
+            double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            // the profiler commits a frame at the start of the next one, so `current` is this frame
+            double present = 0;
+            if(profiler != nullptr){
+                auto it = profiler->phase_ids.find("present");
+                if(it != profiler->phase_ids.end()) present = profiler->phases[it->second].current;
+            }
+            frame_ms.push_back(ms);
+            cpu_frame_ms.push_back(ms - present);
+        }
+        bench_frame++;
+    }
+
+    FILE* fp = output != nullptr ? fopen(output, "w") : stdout;
+    if(fp == nullptr){
+        platform_log_error(_S("Error: failed to write ", output, '\n'));
+        return 1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"frames\": %d,\n", frames);
+    fprintf(fp, "  \"warmup\": %d,\n", warmup);
+    fprintf(fp, "  \"dt\": %.6f,\n", bench_dt);
+    write_stats(fp, "frame_ms", frame_ms);
+    fprintf(fp, ",\n");
+    write_stats(fp, "cpu_frame_ms", cpu_frame_ms);
+    fprintf(fp, ",\n");
+    // per-phase totals of the measured frames, from the game's profiler
+    fprintf(fp, "  \"phases\": {");
+    if(Profiler::current != nullptr){
+        bool first = true;
+        for(const ProfilerPhase& phase: Profiler::current->phases){
+            // the profiler commits a frame at the start of the next one, so add `current`
+            double total = phase.total + phase.current - phase_warmup[phase.name];
+            fprintf(fp, first ? "\n    " : ",\n    ");
+            write_json_string(fp, phase.name);
+            fprintf(fp, ": {\"total_ms\": %.4f, \"mean_ms\": %.4f}", total, total / frames);
+            first = false;
+        }
+        if(!first) fprintf(fp, "\n  ");
+    }
+    fprintf(fp, "}\n");
+    fprintf(fp, "}\n");
+    if(fp != stdout) fclose(fp);
+
+    ios_destroy();
+    return 0;
+}
+
 // not iOS
-#if PK_SYS_PLATFORM != 2
+#elif PK_SYS_PLATFORM != 2
 int main(int argc, char** argv){
     if(argc > 1){
         std::string_view argv_1(argv[1]);
@@ -192,6 +336,9 @@ int main(int argc, char** argv){
             platform_init();
             vm = new VM();
             vm->set_main_argv(argc, argv);
+            // build scripts work on images (e.g. scripts/prepack_atlas.py), no window is opened
+            add_module_raylib(vm);
+            add_module__ct(vm);
             int size;
             const char* data = (const char*)_default_import_handler(argv[1], &size);
             if(data == nullptr){
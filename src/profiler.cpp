@@ -0,0 +1,365 @@
+#include "profiler.hpp"
+#include "appw.hpp"
+#include "imgui.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+namespace ct{
+
+Profiler* Profiler::current = nullptr;
+int Profiler::next_serial = 0;
+
+static double elapsed_ms(Profiler::clock::time_point a, Profiler::clock::time_point b){
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+Profiler::Profiler(int capacity): capacity(capacity), cursor(0), count(0), started(false),
+    trace_size(0), trace_dropped(0), trace_pending(0), trace_frames_left(0), tracing(false){
+    frame_samples.resize(capacity, 0.0f);
+    serial = next_serial++;
+    current = this;
+}
+
+Profiler::~Profiler(){
+    if(current == this) current = nullptr;
+}
+
+int Profiler::phase_id(std::string_view name){
+    std::string key(name);
+    auto it = phase_ids.find(key);
+    if(it != phase_ids.end()) return it->second;
+    int id = phases.size();
+    ProfilerPhase phase;
+    phase.name = key;
+    phase.depth = stack.size();
+    phase.samples.resize(capacity, 0.0f);
+    phase.current = 0;
+    phase.total = 0;
+    phases.push_back(std::move(phase));
+    phase_ids[key] = id;
+    phase_trace_names.push_back(-1);
+    return id;
+}
+
+void Profiler::begin(int phase){
+    int trace_name = -1;
+    if(tracing){
+        trace_name = phase_trace_names[phase];
+        if(trace_name == -1){
+            trace_name = trace_name_id(phases[phase].name);
+            phase_trace_names[phase] = trace_name;
+        }
+    }
+    stack.push_back({phase, trace_name, clock::now()});
+}
+
+void Profiler::trace_begin(int trace_name){
+    stack.push_back({-1, trace_name, clock::now()});
+}
+
+void Profiler::end(){
+    clock::time_point now = clock::now();
+    if(stack.empty()) throw std::runtime_error("profiler end() without begin()");
+    OpenScope scope = stack.back();
+    stack.pop_back();
+    if(scope.phase != -1) phases[scope.phase].current += elapsed_ms(scope.start, now);
+    if(tracing && scope.trace_name != -1) _emit(scope.trace_name, scope.start, now);
+}
+
+int Profiler::trace_name_id(std::string_view name){
+    std::string key(name);
+    auto it = trace_name_ids.find(key);
+    if(it != trace_name_ids.end()) return it->second;
+    int id = trace_names.size();
+    trace_names.push_back(key);
+    trace_name_ids[key] = id;
+    return id;
+}
+
+void Profiler::_emit(int trace_name, clock::time_point start, clock::time_point end){
+    // the arena never grows, events after it is full are counted and dropped
+    if(trace_size == (int)trace_events.size()){
+        trace_dropped++;
+        return;
+    }
+    TraceEvent& e = trace_events[trace_size++];
+    e.name = trace_name;
+    e.ts = std::chrono::duration_cast<std::chrono::nanoseconds>(start - trace_origin).count();
+    e.dur = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+void Profiler::start_trace(int frames, int max_events){
+    if(tracing || trace_pending > 0) return;
+    trace_events.resize(max_events);
+    trace_pending = frames;
+}
+
+void write_json_string(FILE* fp, std::string_view s){
+    fputc('"', fp);
+    for(char c: s){
+        if(c == '"' || c == '\\') fputc('\\', fp);
+        if((unsigned char)c < 0x20) continue;
+        fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+void Profiler::_flush_trace(){
+    char filename[64];
+    std::time_t t = std::time(nullptr);
+    std::strftime(filename, sizeof(filename), "trace_%Y%m%d_%H%M%S.json", std::localtime(&t));
+    std::filesystem::path path(std::string(platform_caches_directory().sv()));
+    path /= filename;
+    last_trace_path = path.string();
+
+    FILE* fp = fopen(last_trace_path.c_str(), "w");
+    if(fp != nullptr){
+        fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}");
+        for(int i=0; i<trace_size; i++){
+            const TraceEvent& e = trace_events[i];
+            fprintf(fp, ",\n{\"name\":");
+            write_json_string(fp, trace_names[e.name]);
+            fprintf(fp, ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}", e.ts / 1000.0, e.dur / 1000.0);
+        }
+        fprintf(fp, "\n],\"otherData\":{\"dropped_events\":%d}}\n", trace_dropped);
+        fclose(fp);
+        platform_log_info(Str("trace saved to " + last_trace_path));
+    }else{
+        platform_log_error(Str("failed to write trace " + last_trace_path));
+    }
+    // release the arena
+    std::vector<TraceEvent>().swap(trace_events);
+    trace_size = 0;
+}
+
+void Profiler::new_frame(){
+    // phases left open by an exception are closed here, so the next frame starts balanced
+    while(!stack.empty()) end();
+    clock::time_point now = clock::now();
+    if(started){
+        frame_samples[cursor] = elapsed_ms(frame_start, now);
+        for(ProfilerPhase& phase: phases){
+            phase.samples[cursor] = phase.current;
+            phase.total += phase.current;
+            phase.current = 0;
+        }
+        cursor = (cursor + 1) % capacity;
+        count = std::min(count + 1, capacity);
+    }
+
+    if(tracing){
+        if(started) _emit(trace_name_id("frame"), frame_start, now);
+        if(--trace_frames_left <= 0){
+            tracing = false;
+            _flush_trace();
+        }
+    }else if(trace_pending > 0){
+        tracing = true;
+        trace_origin = now;
+        trace_frames_left = trace_pending;
+        trace_pending = 0;
+        trace_size = 0;
+        trace_dropped = 0;
+    }
+
+    frame_start = now;
+    started = true;
+}
+
+float Profiler::sample(int phase, int age) const{
+    int i = ((cursor - 1 - age) % capacity + capacity) % capacity;
+    if(phase == -1) return frame_samples[i];
+    return phases[phase].samples[i];
+}
+
+void Profiler::percentiles(int phase, float out[3]) const{
+    out[0] = out[1] = out[2] = 0;
+    if(count == 0) return;
+    std::vector<float> values(count);
+    for(int i=0; i<count; i++) values[i] = sample(phase, i);
+    std::sort(values.begin(), values.end());
+    const float ps[3] = {0.50f, 0.95f, 0.99f};
+    for(int k=0; k<3; k++){
+        int i = (int)std::ceil(ps[k] * count) - 1;
+        out[k] = values[std::clamp(i, 0, count - 1)];
+    }
+}
+
+static const ImU32 kPhaseColors[] = {
+    IM_COL32(230, 80, 80, 255),
+    IM_COL32(80, 170, 230, 255),
+    IM_COL32(240, 190, 60, 255),
+    IM_COL32(110, 200, 100, 255),
+    IM_COL32(190, 110, 220, 255),
+    IM_COL32(240, 140, 60, 255),
+    IM_COL32(90, 210, 190, 255),
+    IM_COL32(220, 120, 170, 255),
+};
+
+void Profiler::render_graph(float height) const{
+    const int num_colors = sizeof(kPhaseColors) / sizeof(ImU32);
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    ImVec2 p0 = ImGui::GetCursorScreenPos();
+    float width = ImGui::GetContentRegionAvail().x;
+    ImGui::Dummy(ImVec2(width, height));
+    draw_list->AddRectFilled(p0, ImVec2(p0.x + width, p0.y + height), IM_COL32(20, 20, 20, 255));
+
+    // scale to the slowest frame, but never zoom in closer than 60 fps
+    float max_ms = 1000.0f / 60;
+    for(int i=0; i<count; i++) max_ms = std::max(max_ms, sample(-1, i));
+    float y_scale = height / max_ms;
+    float bar_w = width / capacity;
+    float bottom = p0.y + height;
+
+    for(int age=0; age<count; age++){
+        float x1 = p0.x + width - age * bar_w;
+        float x0 = x1 - bar_w;
+        // stacked top-level phases, the rest of the frame is left as a gap
+        float y = bottom;
+        int color = 0;
+        for(int k=0; k<phases.size(); k++){
+            if(phases[k].depth != 0) continue;
+            float h = sample(k, age) * y_scale;
+            draw_list->AddRectFilled(ImVec2(x0, y - h), ImVec2(x1, y), kPhaseColors[color++ % num_colors]);
+            y -= h;
+        }
+        float frame_y = bottom - sample(-1, age) * y_scale;
+        draw_list->AddLine(ImVec2(x0, frame_y), ImVec2(x1, frame_y), IM_COL32(255, 255, 255, 200));
+    }
+
+    // 60 and 30 fps guides
+    const float guides[] = {1000.0f / 60, 1000.0f / 30};
+    for(float ms: guides){
+        if(ms > max_ms) continue;
+        float y = bottom - ms * y_scale;
+        draw_list->AddLine(ImVec2(p0.x, y), ImVec2(p0.x + width, y), IM_COL32(255, 255, 255, 60));
+    }
+
+    // legend
+    int color = 0;
+    for(const ProfilerPhase& phase: phases){
+        if(phase.depth != 0) continue;
+        if(color > 0) ImGui::SameLine();
+        ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(kPhaseColors[color++ % num_colors]), "%s", phase.name.c_str());
+    }
+}
+
+// `None` means the whole frame
+static int lookup_phase(VM* vm, const Profiler& self, PyVar name){
+    if(name == vm->None) return -1;
+    auto it = self.phase_ids.find(std::string(CAST(Str&, name).sv()));
+    if(it == self.phase_ids.end()) vm->ValueError("unknown profiler phase");
+    return it->second;
+}
+
+void Profiler::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind(type, "__new__(cls, capacity: int = 240)",
+        [](VM* vm, ArgsView args){
+            int capacity = CAST(int, args[1]);
+            if(capacity <= 0) vm->ValueError("capacity must be positive");
+            return vm->new_user_object<Profiler>(capacity);
+        });
+
+    vm->bind(type, "begin(self, phase: str)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            self.begin(self.phase_id(CAST(Str&, args[1]).sv()));
+            return vm->None;
+        });
+
+    vm->bind(type, "end(self)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            self.end();
+            return vm->None;
+        });
+
+    vm->bind(type, "scope(self, phase: str)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            self.begin(self.phase_id(CAST(Str&, args[1]).sv()));
+            // the profiler is its own context manager, `__exit__` ends the phase
+            return args[0];
+        });
+
+    vm->bind(type, "__enter__(self)",
+        [](VM* vm, ArgsView args){
+            return args[0];
+        });
+
+    vm->bind(type, "__exit__(self, *args)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            self.end();
+            return vm->None;
+        });
+
+    vm->bind(type, "new_frame(self)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            self.new_frame();
+            return vm->None;
+        });
+
+    vm->bind(type, "phases(self) -> list[str]",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            List list;
+            for(const ProfilerPhase& phase: self.phases) list.push_back(VAR(phase.name));
+            return VAR(std::move(list));
+        });
+
+    vm->bind(type, "history(self, phase: str = None) -> list[float]",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            int phase = lookup_phase(vm, self, args[1]);
+            List list;
+            for(int age=self.count-1; age>=0; age--) list.push_back(VAR(self.sample(phase, age)));
+            return VAR(std::move(list));
+        });
+
+    vm->bind(type, "percentiles(self, phase: str = None) -> tuple[float, float, float]",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            int phase = lookup_phase(vm, self, args[1]);
+            float out[3];
+            self.percentiles(phase, out);
+            return VAR(Tuple(VAR(out[0]), VAR(out[1]), VAR(out[2])));
+        });
+
+    vm->bind(type, "start_trace(self, frames: int, max_events: int = 262144)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            int frames = CAST(int, args[1]);
+            int max_events = CAST(int, args[2]);
+            if(frames <= 0 || max_events <= 0) vm->ValueError("frames and max_events must be positive");
+            self.start_trace(frames, max_events);
+            return vm->None;
+        });
+
+    vm->bind(type, "is_tracing(self) -> bool",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            return VAR(self.tracing || self.trace_pending > 0);
+        });
+
+    vm->bind(type, "last_trace_path(self) -> str | None",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            if(self.last_trace_path.empty()) return vm->None;
+            return VAR(self.last_trace_path);
+        });
+
+    vm->bind(type, "render_graph(self, height: float)",
+        [](VM* vm, ArgsView args){
+            Profiler& self = _CAST(Profiler&, args[0]);
+            self.render_graph(CAST_F(args[1]));
+            return vm->None;
+        });
+}
+
+}   // namespace ct
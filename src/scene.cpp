@@ -0,0 +1,399 @@
+#include "scene.hpp"
+
+#include <algorithm>
+
+namespace ct{
+
+void SceneGraph::_check(int id) const{
+    if(id < 0 || id >= (int)slots.size() || !slots[id].alive){
+        throw std::runtime_error("invalid scene graph slot");
+    }
+}
+
+void SceneGraph::_unlink(int id){
+    TransformSlot& s = slots[id];
+    if(s.parent == -1) return;
+    std::vector<int>& siblings = slots[s.parent].children;
+    auto it = std::find(siblings.begin(), siblings.end(), id);
+    if(it != siblings.end()) siblings.erase(it);
+    s.parent = -1;
+}
+
+int SceneGraph::alloc(PyVar node, PyVar position, PyVar scale, int parent){
+    if(parent != -1) _check(parent);
+    int id;
+    if(!free_slots.empty()){
+        id = free_slots.back();
+        free_slots.pop_back();
+    }else{
+        id = slots.size();
+        slots.emplace_back();
+    }
+    TransformSlot& s = slots[id];
+    s.parent = parent;
+    s.alive = true;
+    s.node = node;
+    s.enabled = true;
+    s.children.clear();
+    if(parent != -1) slots[parent].children.push_back(id);
+    s.z_index = 0;
+    s.total_z = 0;
+    s.z_stamp = -1;
+    s.position = position;
+    s.scale = scale;
+    s.rotation = 0;
+    s.world = Mat3x3::identity();
+    s.version = 0;
+    s.parent_version = -1;      // force the first update
+    s.dirty = true;
+    flat_dirty = true;
+    z_dirty = true;
+    return id;
+}
+
+void SceneGraph::release(int id){
+    _check(id);
+    _unlink(id);
+    TransformSlot& s = slots[id];
+    // children are normally released right after, detach them anyway
+    // so that a reused slot never gets stale children
+    for(int child: s.children) slots[child].parent = -1;
+    s.children.clear();
+    s.alive = false;
+    s.node = nullptr;
+    s.position = nullptr;
+    s.scale = nullptr;
+    free_slots.push_back(id);
+    flat_dirty = true;
+}
+
+void SceneGraph::set_parent(int id, int parent){
+    if(id == -1) return;
+    _check(id);
+    if(parent != -1) _check(parent);
+    if(slots[id].parent == parent) return;
+    _unlink(id);
+    TransformSlot& s = slots[id];
+    s.parent = parent;
+    s.parent_version = -1;
+    if(parent != -1) slots[parent].children.push_back(id);
+    _mark_subtree_dirty(id);
+    flat_dirty = true;
+    z_dirty = true;
+    active_version++;
+}
+
+void SceneGraph::set_rotation(int id, float rotation){
+    if(id == -1) return;
+    _check(id);
+    TransformSlot& s = slots[id];
+    if(s.rotation == rotation) return;
+    s.rotation = rotation;
+    _mark_subtree_dirty(id);
+}
+
+void SceneGraph::_mark_subtree_dirty(int id){
+    TransformSlot& s = slots[id];
+    // a dirty slot has a dirty subtree already, so each slot is marked at most once between passes
+    if(s.dirty) return;
+    s.dirty = true;
+    for(int child: s.children) _mark_subtree_dirty(child);
+}
+
+void SceneGraph::set_enabled(int id, bool enabled){
+    if(id == -1) return;
+    _check(id);
+    TransformSlot& s = slots[id];
+    if(s.enabled == enabled) return;
+    s.enabled = enabled;
+    flat_dirty = true;
+    active_version++;
+}
+
+bool SceneGraph::is_active(int id) const{
+    if(id == -1) return false;
+    _check(id);
+    while(id != -1){
+        if(!slots[id].enabled) return false;
+        id = slots[id].parent;
+    }
+    return true;
+}
+
+PyVar SceneGraph::flatten(VM* vm, int root, bool enabled_only){
+    _check(root);
+    if(flat_dirty){
+        flat[0] = flat[1] = nullptr;
+        flat_dirty = false;
+    }
+    PyVar& cached = flat[enabled_only];
+    if(cached != nullptr && flat_root[enabled_only] == root) return cached;
+    // iterative pre-order traversal, children in insertion order
+    std::vector<int>& ids = flat_ids[enabled_only];
+    ids.clear();
+    List list;
+    std::vector<int> stack = {root};
+    while(!stack.empty()){
+        int id = stack.back();
+        stack.pop_back();
+        const TransformSlot& s = slots[id];
+        if(enabled_only && !s.enabled) continue;
+        ids.push_back(id);
+        list.push_back(s.node);
+        for(auto it = s.children.rbegin(); it != s.children.rend(); ++it) stack.push_back(*it);
+    }
+    // always a new list object, so a list being iterated by `fast_apply` is never modified
+    cached = VAR(std::move(list));
+    flat_root[enabled_only] = root;
+    return cached;
+}
+
+void SceneGraph::set_z_index(int id, double z_index){
+    if(id == -1) return;
+    _check(id);
+    TransformSlot& s = slots[id];
+    if(s.z_index == z_index) return;
+    s.z_index = z_index;
+    z_dirty = true;
+}
+
+double SceneGraph::_total_z(int id){
+    TransformSlot& s = slots[id];
+    if(s.z_stamp == z_pass) return s.total_z;
+    s.z_stamp = z_pass;
+    s.total_z = s.z_index;
+    if(s.parent != -1) s.total_z += _total_z(s.parent);
+    return s.total_z;
+}
+
+void SceneGraph::_update_z(){
+    if(!z_dirty) return;
+    z_dirty = false;
+    z_pass++;
+    for(int i=0; i<slots.size(); i++){
+        if(slots[i].alive) _total_z(i);
+    }
+    queue = nullptr;
+}
+
+double SceneGraph::total_z_index(int id){
+    _check(id);
+    _update_z();
+    return slots[id].total_z;
+}
+
+PyVar SceneGraph::render_queue(VM* vm, int root){
+    PyVar enabled = flatten(vm, root, true);
+    _update_z();
+    if(queue != nullptr && queue_source == enabled) return queue;
+
+    // stable bucket sort, there are usually only a few distinct z-index values
+    const std::vector<int>& ids = flat_ids[1];
+    std::vector<double> keys;
+    keys.reserve(ids.size());
+    for(int id: ids) keys.push_back(slots[id].total_z);
+    std::vector<double> buckets = keys;
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+
+    std::vector<int> offsets(buckets.size() + 1, 0);
+    std::vector<int> bucket_of(ids.size());
+    for(int i=0; i<ids.size(); i++){
+        int b = std::lower_bound(buckets.begin(), buckets.end(), keys[i]) - buckets.begin();
+        bucket_of[i] = b;
+        offsets[b + 1]++;
+    }
+    for(int b=0; b<buckets.size(); b++) offsets[b + 1] += offsets[b];
+
+    List list(ids.size());
+    queue_ids.resize(ids.size());
+    for(int i=0; i<ids.size(); i++){
+        int index = offsets[bucket_of[i]]++;
+        list[index] = slots[ids[i]].node;
+        queue_ids[index] = ids[i];
+    }
+    queue = VAR(std::move(list));
+    queue_source = enabled;
+    return queue;
+}
+
+PyVar SceneGraph::render_subtree(VM* vm, int root){
+    _check(root);
+    List list;
+    i64 versions = 0;
+    for(int id: queue_ids){
+        if(id == root || !slots[id].alive) continue;
+        int p = slots[id].parent;
+        while(p != -1 && p != root) p = slots[p].parent;
+        if(p == -1) continue;
+        list.push_back(slots[id].node);
+        versions += slots[id].version;
+    }
+    Tuple t(2);
+    t[0] = VAR(std::move(list));
+    t[1] = VAR(versions);
+    return VAR(std::move(t));
+}
+
+bool SceneGraph::_is_local_dirty(const TransformSlot& s) const{
+    const Vec2& p = PK_OBJ_GET(Vec2, s.position);
+    const Vec2& sc = PK_OBJ_GET(Vec2, s.scale);
+    return p.x != s.cached_position.x || p.y != s.cached_position.y ||
+           sc.x != s.cached_scale.x || sc.y != s.cached_scale.y ||
+           s.rotation != s.cached_rotation;
+}
+
+void SceneGraph::_compute_world(TransformSlot& s, const TransformSlot& parent){
+    s.cached_position = PK_OBJ_GET(Vec2, s.position);
+    s.cached_scale = PK_OBJ_GET(Vec2, s.scale);
+    s.cached_rotation = s.rotation;
+    Mat3x3 local = Mat3x3::trs(s.cached_position, s.cached_rotation, s.cached_scale);
+    parent.world.matmul(local, s.world);
+    s.parent_version = parent.version;
+    s.version++;
+}
+
+const Mat3x3& SceneGraph::world(int id){
+    static const Mat3x3 kIdentity = Mat3x3::identity();
+    if(id == -1) return kIdentity;
+    _check(id);
+    // in-place edits of `position` and `scale` reach no mutator, so compare the local TRS
+    // of the slot and its ancestors, the root's own TRS is ignored
+    for(int a=id; slots[a].parent != -1; a=slots[a].parent){
+        if(_is_local_dirty(slots[a])) _mark_subtree_dirty(a);
+    }
+    return _refresh(id);
+}
+
+const Mat3x3& SceneGraph::_refresh(int id){
+    // NOTE: `slots` never grows inside this function, so references stay valid
+    TransformSlot& s = slots[id];
+    // a clean slot never has a dirty ancestor, so only the dirty part of the chain is walked
+    if(s.parent == -1 || !s.dirty) return s.world;
+    const TransformSlot& parent = slots[s.parent];
+    _refresh(s.parent);
+    if(s.parent_version != parent.version || _is_local_dirty(s)) _compute_world(s, parent);
+    s.dirty = false;
+    return s.world;
+}
+
+void SceneGraph::update_transforms(){
+    // top-down from the roots, a parent is always up to date before its children
+    std::vector<int> stack;
+    for(int i=0; i<slots.size(); i++){
+        TransformSlot& root = slots[i];
+        if(!root.alive || root.parent != -1) continue;
+        root.dirty = false;
+        for(int child: root.children) stack.push_back(child);
+        while(!stack.empty()){
+            TransformSlot& s = slots[stack.back()];
+            stack.pop_back();
+            const TransformSlot& parent = slots[s.parent];
+            // in-place edits are only seen here, so the local TRS is checked even on clean slots
+            if(s.parent_version != parent.version || _is_local_dirty(s)) _compute_world(s, parent);
+            s.dirty = false;
+            for(int child: s.children) stack.push_back(child);
+        }
+    }
+}
+
+void SceneGraph::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind_func(type, __new__, 1, [](VM* vm, ArgsView args){
+        return vm->new_user_object<SceneGraph>();
+    });
+
+    vm->bind(type, "alloc(self, node, position: vec2, scale: vec2, parent: int) -> int",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            PyVar position = args[2];
+            PyVar scale = args[3];
+            if(!is_type(position, vm->_tp_user<Vec2>()) || !is_type(scale, vm->_tp_user<Vec2>())){
+                vm->TypeError("expected vec2 for position and scale");
+            }
+            int parent = CAST(int, args[4]);
+            return VAR(self.alloc(args[1], position, scale, parent));
+        });
+
+    vm->bind(type, "free(self, id: int)",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            self.release(CAST(int, args[1]));
+            return vm->None;
+        });
+
+    vm->bind(type, "set_parent(self, id: int, parent: int)",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            self.set_parent(CAST(int, args[1]), CAST(int, args[2]));
+            return vm->None;
+        });
+
+    vm->bind(type, "set_rotation(self, id: int, rotation: float)",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            self.set_rotation(CAST(int, args[1]), CAST_F(args[2]));
+            return vm->None;
+        });
+
+    vm->bind(type, "set_enabled(self, id: int, enabled: bool)",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            self.set_enabled(CAST(int, args[1]), CAST(bool, args[2]));
+            return vm->None;
+        });
+
+    vm->bind(type, "is_active(self, id: int) -> bool",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            return VAR(self.is_active(CAST(int, args[1])));
+        });
+
+    vm->bind(type, "flatten(self, root: int, enabled_only: bool) -> list",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            return self.flatten(vm, CAST(int, args[1]), CAST(bool, args[2]));
+        });
+
+    vm->bind(type, "set_z_index(self, id: int, z_index: float)",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            self.set_z_index(CAST(int, args[1]), CAST_F(args[2]));
+            return vm->None;
+        });
+
+    vm->bind(type, "total_z_index(self, id: int) -> int | float",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            double z = self.total_z_index(CAST(int, args[1]));
+            // keep integers as int, like the sum of int z-index values in python
+            if(z == (i64)z) return VAR((i64)z);
+            return VAR(z);
+        });
+
+    vm->bind(type, "render_queue(self, root: int) -> list",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            return self.render_queue(vm, CAST(int, args[1]));
+        });
+
+    vm->bind(type, "render_subtree(self, root: int) -> tuple[list, int]",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            return self.render_subtree(vm, CAST(int, args[1]));
+        });
+
+    vm->bind(type, "transform(self, id: int) -> mat3x3",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            return VAR(self.world(CAST(int, args[1])));
+        });
+
+    vm->bind(type, "update_transforms(self)",
+        [](VM* vm, ArgsView args){
+            SceneGraph& self = _CAST(SceneGraph&, args[0]);
+            self.update_transforms();
+            return vm->None;
+        });
+}
+
+}   // namespace ct
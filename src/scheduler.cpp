@@ -0,0 +1,366 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ct{
+
+static const double kTicksPerSecond = 1000.0;
+
+void TimerWheel::insert(TimerEntry e){
+    count++;
+    // an entry never goes into the past, it expires on the next tick at the latest
+    if(e.deadline <= current) e.deadline = current + 1;
+    i64 delta = e.deadline - current;
+    for(int level=0; level<kLevels; level++){
+        if(delta < ((i64)1 << (kBits * (level + 1)))){
+            int index = (e.deadline >> (kBits * level)) & (kSize - 1);
+            slots[level][index].push_back(e);
+            return;
+        }
+    }
+    overflow.push_back(e);
+}
+
+void TimerWheel::advance(i64 target, std::vector<TimerEntry>& out){
+    while(current < target){
+        if(count == 0){
+            current = target;
+            return;
+        }
+        current++;
+        // cascade from the top level, so that a cascaded entry can land in a lower slot of this tick
+        if((current & (((i64)1 << (kBits * kLevels)) - 1)) == 0){
+            std::vector<TimerEntry> entries;
+            entries.swap(overflow);
+            count -= entries.size();
+            for(TimerEntry e: entries) insert(e);
+        }
+        for(int level=kLevels-1; level>0; level--){
+            if((current & (((i64)1 << (kBits * level)) - 1)) != 0) continue;
+            int index = (current >> (kBits * level)) & (kSize - 1);
+            std::vector<TimerEntry> entries;
+            entries.swap(slots[level][index]);
+            count -= entries.size();
+            for(TimerEntry e: entries) insert(e);
+        }
+        std::vector<TimerEntry>& expired = slots[0][current & (kSize - 1)];
+        out.insert(out.end(), expired.begin(), expired.end());
+        count -= expired.size();
+        expired.clear();
+    }
+}
+
+void Scheduler::_reset_owner(CoroutineOwner& o){
+    o.tasks.clear();
+    o.ready = false;
+    o.active = true;
+    o.time_scale = 1;
+    o.base_global = time;
+    o.base_local = time;
+}
+
+CoroutineOwner& Scheduler::_owner(int id){
+    if(id >= (int)owners.size()){
+        int old_size = owners.size();
+        owners.resize(id + 1);
+        for(int i=old_size; i<owners.size(); i++) _reset_owner(owners[i]);
+    }
+    return owners[id];
+}
+
+int Scheduler::_alloc_task(int owner, PyVar coroutine){
+    int id;
+    if(!free_tasks.empty()){
+        id = free_tasks.back();
+        free_tasks.pop_back();
+    }else{
+        id = tasks.size();
+        tasks.emplace_back();
+        tasks[id].epoch = 0;
+    }
+    CoroutineTask& t = tasks[id];
+    t.coroutine = coroutine;
+    t.owner = owner;
+    t.epoch++;
+    t.waiting = false;
+    t.deadline = -1;
+    t.remaining = 0;
+    return id;
+}
+
+void Scheduler::_free_task(int id){
+    CoroutineTask& t = tasks[id];
+    t.coroutine = nullptr;
+    t.epoch++;              // drop its timer entry, if any
+    t.waiting = false;
+    free_tasks.push_back(id);
+}
+
+void Scheduler::_stop_task(int id){
+    CoroutineTask& t = tasks[id];
+    if(t.waiting){
+        _free_task(id);
+    }else{
+        // it is in `ready` or being resumed, `update()` frees it later
+        t.coroutine = nullptr;
+    }
+}
+
+void Scheduler::_detach(int owner, int id){
+    std::vector<int>& list = owners[owner].tasks;
+    auto it = std::find(list.begin(), list.end(), id);
+    if(it != list.end()) list.erase(it);
+}
+
+void Scheduler::_park(int id, double seconds){
+    CoroutineTask& t = tasks[id];
+    const CoroutineOwner& o = owners[t.owner];
+    t.waiting = true;
+    t.epoch++;              // drop the previous timer entry, if any
+    if(o.time_scale <= 0 || !o.active){
+        // frozen until the owner is active and its time scale is positive again
+        t.deadline = -1;
+        t.remaining = seconds;
+        return;
+    }
+    t.deadline = (i64)std::ceil((time + seconds / o.time_scale) * kTicksPerSecond);
+    wheel.insert({id, t.epoch, t.deadline});
+}
+
+double Scheduler::_remaining(const CoroutineTask& t, const CoroutineOwner& o) const{
+    if(t.deadline == -1) return t.remaining;
+    return std::max(0.0, (t.deadline / kTicksPerSecond - time) * o.time_scale);
+}
+
+void Scheduler::_update_active(const SceneGraph& graph){
+    if(active_version == graph.active_version) return;
+    active_version = graph.active_version;
+    for(int owner=0; owner<owners.size(); owner++){
+        CoroutineOwner& o = owners[owner];
+        if(o.tasks.empty()){
+            // a coroutine only parks right after it ran, so a new one parks as active
+            o.active = true;
+            continue;
+        }
+        bool active = graph.slots[owner].alive && graph.is_active(owner);
+        if(o.active == active) continue;
+        // disabled nodes were not updated before the scheduler, so their waits do not advance
+        for(int id: o.tasks){
+            CoroutineTask& t = tasks[id];
+            if(t.waiting) t.remaining = _remaining(t, o);
+        }
+        o.active = active;
+        for(int id: o.tasks){
+            if(tasks[id].waiting) _park(id, tasks[id].remaining);
+        }
+    }
+}
+
+void Scheduler::start(int owner, PyVar coroutine){
+    if(owner == -1) return;
+    int id = _alloc_task(owner, coroutine);
+    _owner(owner).tasks.push_back(id);
+    ready.push_back(id);
+}
+
+void Scheduler::stop(int owner, PyVar coroutine){
+    if(owner == -1 || owner >= (int)owners.size()) return;
+    std::vector<int>& list = owners[owner].tasks;
+    for(int i=0; i<list.size(); i++){
+        int id = list[i];
+        if(tasks[id].coroutine == coroutine){
+            list.erase(list.begin() + i);
+            _stop_task(id);
+            return;
+        }
+    }
+}
+
+void Scheduler::stop_all(int owner){
+    if(owner == -1 || owner >= (int)owners.size()) return;
+    std::vector<int>& list = owners[owner].tasks;
+    for(int id: list) _stop_task(id);
+    list.clear();
+}
+
+void Scheduler::release(int owner){
+    if(owner == -1 || owner >= (int)owners.size()) return;
+    stop_all(owner);
+    _reset_owner(owners[owner]);
+}
+
+void Scheduler::set_ready(int owner){
+    if(owner == -1) return;
+    _owner(owner).ready = true;
+}
+
+int Scheduler::count(int owner) const{
+    if(owner == -1 || owner >= (int)owners.size()) return 0;
+    return owners[owner].tasks.size();
+}
+
+float Scheduler::get_time_scale(int owner) const{
+    if(owner == -1 || owner >= (int)owners.size()) return 1;
+    return owners[owner].time_scale;
+}
+
+double Scheduler::local_time(int owner) const{
+    if(owner == -1 || owner >= (int)owners.size()) return time;
+    const CoroutineOwner& o = owners[owner];
+    return o.base_local + (time - o.base_global) * o.time_scale;
+}
+
+void Scheduler::set_time_scale(int owner, float scale){
+    if(owner == -1) return;
+    CoroutineOwner& o = _owner(owner);
+    if(o.time_scale == scale) return;
+    // remaining seconds of parked coroutines, measured by the old clock
+    for(int id: o.tasks){
+        CoroutineTask& t = tasks[id];
+        if(t.waiting) t.remaining = _remaining(t, o);
+    }
+    o.base_local = local_time(owner);
+    o.base_global = time;
+    o.time_scale = scale;
+    for(int id: o.tasks){
+        if(tasks[id].waiting) _park(id, tasks[id].remaining);
+    }
+}
+
+void Scheduler::update(VM* vm, double dt){
+    const SceneGraph& graph = PK_OBJ_GET(SceneGraph, graph_obj);
+    // 1. freeze the waits of disabled nodes before their deadlines can expire
+    _update_active(graph);
+    time += dt;
+
+    // 2. move coroutines whose deadline has expired to `ready`
+    wheel.advance((i64)std::floor(time * kTicksPerSecond), _expired);
+    for(TimerEntry e: _expired){
+        CoroutineTask& t = tasks[e.task];
+        if(t.epoch != e.epoch || !t.waiting) continue;     // stopped or rescheduled
+        t.waiting = false;
+        ready.push_back(e.task);
+    }
+    _expired.clear();
+
+    // 3. resume ready coroutines, coroutines started meanwhile run on the next update
+    _running.swap(ready);
+    for(int id: _running){
+        if(tasks[id].coroutine == nullptr){
+            _free_task(id);
+            continue;
+        }
+        int owner = tasks[id].owner;
+        // coroutines of unready or inactive nodes are paused
+        if(!owners[owner].ready || !graph.is_active(owner)){
+            _kept.push_back(id);
+            continue;
+        }
+        PyVar ret = vm->py_next(tasks[id].coroutine);
+        // NOTE: `tasks` may have grown during `py_next`, do not keep references across it
+        if(tasks[id].coroutine == nullptr){
+            _free_task(id);         // stopped by itself
+            continue;
+        }
+        if(ret == vm->StopIteration){
+            _detach(owner, id);
+            _free_task(id);
+            continue;
+        }
+        if(vm->isinstance(ret, wait_type)){
+            double seconds = CAST_F(vm->getattr(ret, "_seconds"));
+            if(seconds > 0){
+                // the wait object ends on its next `__next__()` instead of measuring time
+                vm->setattr(ret, "_parked", vm->True);
+                _park(id, seconds);
+                continue;
+            }
+        }
+        _kept.push_back(id);
+    }
+    _running.clear();
+    _kept.insert(_kept.end(), ready.begin(), ready.end());
+    ready.swap(_kept);
+    _kept.clear();
+}
+
+void Scheduler::_register(VM* vm, PyVar mod, PyVar type){
+    vm->bind_func(type, __new__, 3, [](VM* vm, ArgsView args){
+        PyVar graph = args[1];
+        if(!is_type(graph, vm->_tp_user<SceneGraph>())) vm->TypeError("expected SceneGraph");
+        if(!is_type(args[2], vm->tp_type)) vm->TypeError("expected a type for wait objects");
+        return vm->new_user_object<Scheduler>(graph, PK_OBJ_GET(Type, args[2]));
+    });
+
+    vm->bind(type, "start(self, owner: int, coroutine)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            self.start(CAST(int, args[1]), args[2]);
+            return vm->None;
+        });
+
+    vm->bind(type, "stop(self, owner: int, coroutine)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            self.stop(CAST(int, args[1]), args[2]);
+            return vm->None;
+        });
+
+    vm->bind(type, "stop_all(self, owner: int)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            self.stop_all(CAST(int, args[1]));
+            return vm->None;
+        });
+
+    vm->bind(type, "free(self, owner: int)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            self.release(CAST(int, args[1]));
+            return vm->None;
+        });
+
+    vm->bind(type, "set_ready(self, owner: int)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            self.set_ready(CAST(int, args[1]));
+            return vm->None;
+        });
+
+    vm->bind(type, "count(self, owner: int) -> int",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            return VAR(self.count(CAST(int, args[1])));
+        });
+
+    vm->bind(type, "get_time_scale(self, owner: int) -> float",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            return VAR(self.get_time_scale(CAST(int, args[1])));
+        });
+
+    vm->bind(type, "set_time_scale(self, owner: int, scale: float)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            float scale = CAST_F(args[2]);
+            if(scale < 0) vm->ValueError("time scale must be non-negative");
+            self.set_time_scale(CAST(int, args[1]), scale);
+            return vm->None;
+        });
+
+    vm->bind(type, "time(self, owner: int) -> float",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            return VAR(self.local_time(CAST(int, args[1])));
+        });
+
+    vm->bind(type, "update(self, dt: float)",
+        [](VM* vm, ArgsView args){
+            Scheduler& self = _CAST(Scheduler&, args[0]);
+            self.update(vm, CAST_F(args[1]));
+            return vm->None;
+        });
+}
+
+}   // namespace ct
@@ -0,0 +1,281 @@
+#include "sprite_batch.hpp"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ct{
+
+void MaterialValues::set_texture(int loc, unsigned int texture_id){
+    if(loc < 0) return;
+    for(MaterialTexture& t: textures){
+        if(t.loc == loc){
+            t.texture_id = texture_id;
+            return;
+        }
+    }
+    textures.push_back(MaterialTexture{loc, texture_id});
+}
+
+void MaterialValues::set_uniform(int loc, int type, const float* value){
+    if(loc < 0) return;
+    MaterialUniform u = {loc, type, {0, 0, 0, 0}};
+    std::copy(value, value + (type - SHADER_UNIFORM_FLOAT + 1), u.value);
+    for(MaterialUniform& e: uniforms){
+        if(e.loc == loc){
+            e = u;
+            return;
+        }
+    }
+    uniforms.push_back(u);
+}
+
+bool MaterialValues::operator==(const MaterialValues& other) const{
+    if(shader.id != other.shader.id) return false;
+    if(textures.size() != other.textures.size() || uniforms.size() != other.uniforms.size()) return false;
+    for(int i=0; i<textures.size(); i++){
+        if(textures[i].loc != other.textures[i].loc || textures[i].texture_id != other.textures[i].texture_id) return false;
+    }
+    for(int i=0; i<uniforms.size(); i++){
+        const MaterialUniform& a = uniforms[i];
+        const MaterialUniform& b = other.uniforms[i];
+        if(a.loc != b.loc || a.type != b.type || !std::equal(a.value, a.value + 4, b.value)) return false;
+    }
+    return true;
+}
+
+void MaterialValues::apply_uniforms() const{
+    if(uniforms.empty()) return;
+    rlEnableShader(shader.id);
+    for(const MaterialUniform& u: uniforms) rlSetUniform(u.loc, u.value, u.type, 1);
+}
+
+void MaterialValues::apply_textures() const{
+    if(textures.empty()) return;
+    rlEnableShader(shader.id);
+    for(const MaterialTexture& t: textures) rlSetUniformSampler(t.loc, t.texture_id);
+}
+
+void SpriteBatch::_bind_material(const MaterialValues& m){
+    if(m.shader.id == shader_id){
+        if(m == applied){
+            // a flush since the last bind may have dropped the extra textures
+            m.apply_textures();
+            return;
+        }
+        // same shader with other values, draw the sprites that used the old ones
+        rlDrawRenderBatchActive();
+    }else{
+        // flushes the pending quads drawn with the previous shader
+        if(m.shader.id == 0){
+            rlSetShader(rlGetShaderIdDefault(), rlGetShaderLocsDefault());
+        }else{
+            rlSetShader(m.shader.id, m.shader.locs);
+        }
+        shader_id = m.shader.id;
+        shader_switches++;
+    }
+    m.apply_uniforms();
+    m.apply_textures();
+    applied = m;
+}
+
+bool SpriteBatch::set_material(const MaterialValues& m, bool sticky){
+    if(scene != nullptr){
+        if(sticky){
+            // bound when the recorded sprites are flushed
+            int index = m == MaterialValues() ? -1 : list.add_material(m);
+            bool changed = index != deferred_material;
+            deferred_material = index;
+            return changed;
+        }
+        // a scope draws right away, after everything recorded before it
+        flush();
+        scoped = true;
+    }
+    this->sticky = sticky;
+    bool changed = m.shader.id != shader_id || m != applied;
+    _bind_material(m);
+    return changed;
+}
+
+void SpriteBatch::reset_shader(){
+    sticky = false;
+    scoped = false;
+    deferred_material = -1;
+    if(shader_id == 0) return;
+    _bind_material(MaterialValues());
+}
+
+void SpriteBatch::release_shader(){
+    deferred_material = -1;
+    if(sticky) reset_shader();
+}
+
+void SpriteBatch::begin_deferred(SceneGraph* scene){
+    flush();
+    this->scene = scene;
+}
+
+int DrawList::add_material(const MaterialValues& m){
+    // a frame has only a few distinct materials, the last one is the most likely
+    for(int i=(int)materials.size()-1; i>=0; i--){
+        if(materials[i] == m) return i;
+    }
+    materials.push_back(m);
+    return (int)materials.size() - 1;
+}
+
+void DrawList::compile(){
+    auto shader_of = [this](int material){
+        return material == -1 ? 0u : materials[material].shader.id;
+    };
+    // the render queue is already sorted by z, the sort only reorders sprites of an equal z
+    std::stable_sort(commands.begin(), commands.end(), [&](const DrawCommand& a, const DrawCommand& b){
+        if(a.z != b.z) return a.z < b.z;
+        unsigned int shader_a = shader_of(a.material);
+        unsigned int shader_b = shader_of(b.material);
+        if(shader_a != shader_b) return shader_a < shader_b;
+        if(a.material != b.material) return a.material < b.material;
+        return a.texture_id < b.texture_id;
+    });
+    runs.clear();
+    for(int i=0; i<commands.size(); i++){
+        const DrawCommand& cmd = commands[i];
+        if(!runs.empty()){
+            DrawRun& last = runs.back();
+            if(last.material == cmd.material && last.texture_id == cmd.texture_id){
+                last.count++;
+                continue;
+            }
+        }
+        runs.push_back(DrawRun{cmd.material, cmd.texture_id, i, 1});
+    }
+}
+
+void SpriteBatch::replay(const DrawList& draw_list){
+    // quads per `rlBegin()`, well below the capacity of the render batch
+    const int CHUNK_QUADS = 256;
+    static const MaterialValues default_material;
+    for(const DrawRun& run: draw_list.runs){
+        const MaterialValues& m = run.material == -1 ? default_material : draw_list.materials[run.material];
+        _bind_material(m);
+        for(int first=run.first; first<run.first+run.count; first+=CHUNK_QUADS){
+            int last = std::min(first + CHUNK_QUADS, run.first + run.count);
+            // rlgl draws the batch when it is full, which drops the extra textures of the material
+            rlCheckRenderBatchLimit((last - first) * 4);
+            // one texture bind and one `rlBegin()` per chunk of the run
+            rlSetTexture(run.texture_id);
+            rlBegin(RL_QUADS);
+            m.apply_textures();
+            rlNormal3f(0.0f, 0.0f, 1.0f);
+            for(int i=first; i<last; i++){
+                const SpriteQuad& q = draw_list.commands[i].quad;
+                rlColor4ub(q.color.r, q.color.g, q.color.b, q.color.a);
+                rlTexCoord2f(q.u0, q.v0);
+                rlVertex2f(q.tl.x, q.tl.y);
+                rlTexCoord2f(q.u0, q.v1);
+                rlVertex2f(q.bl.x, q.bl.y);
+                rlTexCoord2f(q.u1, q.v1);
+                rlVertex2f(q.br.x, q.br.y);
+                rlTexCoord2f(q.u1, q.v0);
+                rlVertex2f(q.tr.x, q.tr.y);
+            }
+            rlEnd();
+        }
+        rlSetTexture(0);
+        draw_runs++;
+    }
+}
+
+void SpriteBatch::flush(){
+    if(!list.commands.empty()){
+        list.compile();
+        replay(list);
+        list.clear();
+        sticky = true;
+    }
+    release_shader();
+}
+
+void SpriteBatch::end_deferred(){
+    flush();
+    scene = nullptr;
+    scoped = false;
+}
+
+void SpriteBatch::draw(const Mat3x3& transform, bool ui, Texture2D texture, Rectangle src, bool flip_x, bool flip_y, Color color, Vector2 origin, int node){
+    if(texture.id == 0) return;
+
+    Vec2 pos, scale;
+    float rot;
+    if(ui){
+        pos = transform._t();
+        rot = transform._r();
+        scale = transform._s();
+    }else{
+        Mat3x3 m;
+        PK_OBJ_GET(Mat3x3, world_to_viewport).matmul(transform, m);
+        pos = m._t();
+        rot = m._r();
+        scale = m._s() / pixel_per_unit;
+    }
+
+    // same geometry as `DrawTexturePro()`, rotating around the origin
+    float w = src.width * scale.x;
+    float h = src.height * scale.y;
+    float dx = -origin.x * w;
+    float dy = -origin.y * h;
+    float c = std::cos(rot);
+    float s = std::sin(rot);
+    SpriteQuad q;
+    q.tl = {pos.x + dx*c - dy*s,           pos.y + dx*s + dy*c};
+    q.tr = {pos.x + (dx+w)*c - dy*s,       pos.y + (dx+w)*s + dy*c};
+    q.bl = {pos.x + dx*c - (dy+h)*s,       pos.y + dx*s + (dy+h)*c};
+    q.br = {pos.x + (dx+w)*c - (dy+h)*s,   pos.y + (dx+w)*s + (dy+h)*c};
+
+    q.u0 = src.x / texture.width;
+    q.u1 = (src.x + src.width) / texture.width;
+    q.v0 = src.y / texture.height;
+    q.v1 = (src.y + src.height) / texture.height;
+    if(flip_x) std::swap(q.u0, q.u1);
+    if(flip_y) std::swap(q.v0, q.v1);
+    q.color = color;
+    sprite_count++;
+
+    if(scene != nullptr && !scoped){
+        double z = 0;
+        if(node >= 0 && node < scene->slots.size()){
+            z = scene->slots[node].total_z;
+        }else if(!list.commands.empty()){
+            // not a node, keep it right after the previous sprite
+            z = list.commands.back().z;
+        }
+        list.commands.push_back(DrawCommand{z, deferred_material, texture.id, q});
+        return;
+    }
+    emit(texture.id, q);
+}
+
+void SpriteBatch::emit(unsigned int texture_id, const SpriteQuad& q){
+    rlCheckRenderBatchLimit(4);
+    rlSetTexture(texture_id);
+    rlBegin(RL_QUADS);
+        // see `replay()`
+        applied.apply_textures();
+        rlColor4ub(q.color.r, q.color.g, q.color.b, q.color.a);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+        rlTexCoord2f(q.u0, q.v0);
+        rlVertex2f(q.tl.x, q.tl.y);
+        rlTexCoord2f(q.u0, q.v1);
+        rlVertex2f(q.bl.x, q.bl.y);
+        rlTexCoord2f(q.u1, q.v1);
+        rlVertex2f(q.br.x, q.br.y);
+        rlTexCoord2f(q.u1, q.v0);
+        rlVertex2f(q.tr.x, q.tr.y);
+    rlEnd();
+    // does not end the draw call, the next quad of the same texture is merged into it
+    rlSetTexture(0);
+}
+
+}   // namespace ct
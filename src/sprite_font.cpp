@@ -0,0 +1,119 @@
+#include "sprite_font.hpp"
+#include "rlgl.h"
+
+#include <algorithm>
+
+namespace ct{
+
+SpriteFont::SpriteFont(Texture2D texture, int n_rows, int n_cols, std::string_view chars):
+    texture(texture), n_rows(n_rows), n_cols(n_cols),
+    cell_width(texture.width / n_cols), cell_height(texture.height / n_rows) {
+    int index = 0;
+    int i = 0;
+    while(i < chars.size()){
+        int count = 0;
+        int codepoint = GetCodepoint(chars.data() + i, &count);
+        i += std::max(count, 1);
+        if(codepoint >= (int)cell_of.size()) cell_of.resize(codepoint + 1, -1);
+        cell_of[codepoint] = index++;
+    }
+}
+
+// number of codepoints of each line
+static void count_lines(std::string_view text, std::vector<int>& lines){
+    lines.assign(1, 0);
+    int i = 0;
+    while(i < text.size()){
+        int count = 0;
+        int codepoint = GetCodepoint(text.data() + i, &count);
+        i += std::max(count, 1);
+        if(codepoint == '\n') lines.push_back(0);
+        else lines.back()++;
+    }
+}
+
+static float line_width(int glyphs, float cell_width, float spacing){
+    return glyphs == 0 ? 0.0f : glyphs * cell_width + (glyphs - 1) * spacing;
+}
+
+Vector2 SpriteFont::measure(std::string_view text, float spacing, float line_spacing) const{
+    if(text.empty()) return Vector2{0, 0};
+    std::vector<int> lines;
+    count_lines(text, lines);
+    float width = 0;
+    for(int glyphs: lines) width = std::max(width, line_width(glyphs, (float)cell_width, spacing));
+    float height = lines.size() * cell_height + (lines.size() - 1) * line_spacing;
+    return Vector2{width, height};
+}
+
+void SpriteFont::draw(SpriteBatch& batch, const Mat3x3& transform, bool ui, std::string_view text, float spacing, float line_spacing, Color color, Vector2 origin, float align){
+    if(text.empty() || texture.id == 0) return;
+
+    // the scale is taken before the viewport transform, glyphs are sized in pixels
+    Vec2 scale = transform._s();
+    Vec2 pos;
+    if(ui){
+        pos = transform._t();
+    }else{
+        Mat3x3 m;
+        PK_OBJ_GET(Mat3x3, batch.world_to_viewport).matmul(transform, m);
+        pos = m._t();
+    }
+
+    std::vector<int> lines;
+    count_lines(text, lines);
+    float dst_w = cell_width * scale.x;
+    float dst_h = cell_height * scale.y;
+    spacing *= scale.x;
+    line_spacing *= scale.y;
+    float block_w = 0;
+    for(int glyphs: lines) block_w = std::max(block_w, line_width(glyphs, dst_w, spacing));
+    float block_h = lines.size() * dst_h + (lines.size() - 1) * line_spacing;
+    float left = pos.x - block_w * origin.x;
+    float top = pos.y - block_h * origin.y;
+
+    float tex_w = (float)texture.width;
+    float tex_h = (float)texture.height;
+
+    // recorded sprites go first, glyphs are not sorted with them
+    batch.flush();
+    rlSetTexture(texture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    int line = 0;
+    float x = left + (block_w - line_width(lines[0], dst_w, spacing)) * align;
+    float y = top;
+    int i = 0;
+    while(i < text.size()){
+        int count = 0;
+        int codepoint = GetCodepoint(text.data() + i, &count);
+        i += std::max(count, 1);
+        if(codepoint == '\n'){
+            line++;
+            x = left + (block_w - line_width(lines[line], dst_w, spacing)) * align;
+            y += dst_h + line_spacing;
+            continue;
+        }
+        int cell = find_cell(codepoint);
+        if(cell >= 0){
+            float u0 = (cell % n_cols) * cell_width / tex_w;
+            float v0 = (cell / n_cols) * cell_height / tex_h;
+            float u1 = u0 + cell_width / tex_w;
+            float v1 = v0 + cell_height / tex_h;
+            rlTexCoord2f(u0, v0);
+            rlVertex2f(x, y);
+            rlTexCoord2f(u0, v1);
+            rlVertex2f(x, y + dst_h);
+            rlTexCoord2f(u1, v1);
+            rlVertex2f(x + dst_w, y + dst_h);
+            rlTexCoord2f(u1, v0);
+            rlVertex2f(x + dst_w, y);
+        }
+        x += dst_w + spacing;
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+}   // namespace ct
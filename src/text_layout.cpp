@@ -0,0 +1,293 @@
+#include "text_layout.hpp"
+#include "dynamic_font.hpp"
+#include "rlgl.h"
+
+#include <algorithm>
+
+namespace ct{
+
+static int hex_digit(char c){
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void parse_color_markup(std::string_view text, std::string& out, std::vector<ColorSpan>& spans){
+    const std::string_view open = "<color=#";
+    const std::string_view close = "</color>";
+    out.clear();
+    spans.clear();
+    out.reserve(text.size());
+
+    size_t i = 0;
+    while(i < text.size()){
+        // "<color=#" + 6 hex digits + ">"
+        if(text[i] == '<' && text.substr(i, open.size()) == open && i + open.size() + 7 <= text.size()){
+            size_t p = i + open.size();
+            int digits[6];
+            bool ok = text[p + 6] == '>';
+            for(int j=0; j<6 && ok; j++){
+                digits[j] = hex_digit(text[p + j]);
+                ok = digits[j] >= 0;
+            }
+            size_t content = p + 7;
+            size_t end = ok ? text.find(close, content) : std::string_view::npos;
+            // the content may not span lines
+            if(end != std::string_view::npos && text.substr(content, end - content).find_first_of("\r\n") == std::string_view::npos){
+                Color color = {
+                    (unsigned char)(digits[0] * 16 + digits[1]),
+                    (unsigned char)(digits[2] * 16 + digits[3]),
+                    (unsigned char)(digits[4] * 16 + digits[5]),
+                    255
+                };
+                int begin = (int)out.size();
+                out.append(text.substr(content, end - content));
+                spans.push_back(ColorSpan{begin, (int)out.size(), color});
+                i = end + close.size();
+                continue;
+            }
+        }
+        out.push_back(text[i]);
+        i++;
+    }
+}
+
+// same geometry as `DrawTextCodepoint()`
+static void add_glyph(TextLayout& out, Font font, int index, Vector2 position, float scale_factor, int span){
+    const GlyphInfo& info = font.glyphs[index];
+    const Rectangle& rec = font.recs[index];
+    float padding = (float)font.glyphPadding;
+    LayoutGlyph g;
+    g.dst = {
+        position.x + info.offsetX * scale_factor - padding * scale_factor,
+        position.y + info.offsetY * scale_factor - padding * scale_factor,
+        (rec.width + 2.0f * padding) * scale_factor,
+        (rec.height + 2.0f * padding) * scale_factor
+    };
+    g.src = {rec.x - padding, rec.y - padding, rec.width + 2.0f * padding, rec.height + 2.0f * padding};
+    g.span = span;
+    out.glyphs.push_back(g);
+}
+
+// https://github.com/raysan5/raylib/blob/master/examples/text/text_rectangle_bounds.c
+void layout_text_boxed(TextLayout& out, Font font, std::string_view markup, float width, float height, float font_size, float spacing, float line_spacing, bool limit_height, bool word_wrap){
+    std::string text_string;
+    parse_color_markup(markup, text_string, out.spans);
+    out.glyphs.clear();
+
+    // span of each byte of the plain text
+    std::vector<int> span_of(text_string.size(), -1);
+    for(int s=0; s<out.spans.size(); s++){
+        for(int i=out.spans[s].begin; i<out.spans[s].end; i++) span_of[i] = s;
+    }
+
+    const char* text = text_string.c_str();
+    int length = (int)text_string.size();
+
+#define MOVE_NEXT_LINE()  { textOffsetY += (font.baseSize + line_spacing)*scaleFactor; textOffsetX = 0; }
+
+    float textOffsetY = 0;          // Offset between lines (on line break '\n')
+    float textOffsetX = 0.0f;       // Offset X to next character to draw
+
+    float scaleFactor = font_size/(float)font.baseSize;     // Character rectangle scaling factor
+
+    // Word/character wrapping mechanism variables
+    enum { MEASURE_STATE = 0, DRAW_STATE = 1 };
+    int state = word_wrap? MEASURE_STATE : DRAW_STATE;
+
+    int startLine = -1;         // Index where to begin drawing (where a line begins)
+    int endLine = -1;           // Index where to stop drawing (where a line ends)
+    int lastk = -1;             // Holds last value of the character position
+
+    for (int i = 0, k = 0; i < length; i++, k++)
+    {
+        // Get next codepoint from byte string and glyph index in font
+        int codepointByteCount = 0;
+        int codepoint = GetCodepoint(&text[i], &codepointByteCount);
+        int index = GetGlyphIndex(font, codepoint);
+
+        // NOTE: Normally we exit the decoding sequence as soon as a bad byte is found (and return 0x3f)
+        // but we need to draw all of the bad bytes using the '?' symbol moving one byte
+        if (codepoint == 0x3f) codepointByteCount = 1;
+        i += (codepointByteCount - 1);
+
+        float glyphWidth = 0;
+        if (codepoint != '\n')
+        {
+            glyphWidth = (font.glyphs[index].advanceX == 0) ? font.recs[index].width*scaleFactor : font.glyphs[index].advanceX*scaleFactor;
+
+            if (i + 1 < length) glyphWidth = glyphWidth + spacing;
+        }
+
+        // NOTE: When wordWrap is ON we first measure how much of the text we can draw before going outside of the rec container
+        // We store this info in startLine and endLine, then we change states, draw the text between those two variables
+        // and change states again and again recursively until the end of the text (or until we get outside of the container).
+        // When wordWrap is OFF we don't need the measure state so we go to the drawing state immediately
+        // and begin drawing on the next line before we can get outside the container.
+        if (state == MEASURE_STATE)
+        {
+            // TODO: There are multiple types of spaces in UNICODE, maybe it's a good idea to add support for more
+            // Ref: http://jkorpela.fi/chars/spaces.html
+            if ((codepoint == ' ') || (codepoint == '\t') || (codepoint == '\n')) endLine = i;
+
+            if ((textOffsetX + glyphWidth) > width)
+            {
+                endLine = (endLine < 1)? i : endLine;
+                if (i == endLine) endLine -= codepointByteCount;
+                if ((startLine + codepointByteCount) == endLine) endLine = (i - codepointByteCount);
+
+                state = !state;
+            }
+            else if ((i + 1) == length)
+            {
+                endLine = i;
+                state = !state;
+            }
+            else if (codepoint == '\n') state = !state;
+
+            if (state == DRAW_STATE)
+            {
+                textOffsetX = 0;
+                i = startLine;
+                glyphWidth = 0;
+
+                // Save character position when we switch states
+                int tmp = lastk;
+                lastk = k - 1;
+                k = tmp;
+            }
+        }
+        else
+        {
+            if (codepoint == '\n')
+            {
+                if (!word_wrap)
+                {
+                    MOVE_NEXT_LINE()
+                }
+            }
+            else
+            {
+                if (!word_wrap && ((textOffsetX + glyphWidth) > width))
+                {
+                    MOVE_NEXT_LINE()
+                }
+
+                // When text overflows rectangle height limit, just stop drawing
+                if(limit_height){
+                    if ((textOffsetY + font.baseSize*scaleFactor) > height) break;
+                }
+
+                // Record current character glyph
+                if ((codepoint != ' ') && (codepoint != '\t'))
+                {
+                    add_glyph(out, font, index, Vector2{ textOffsetX, textOffsetY }, scaleFactor, span_of[i]);
+                }
+            }
+
+            if (word_wrap && (i == endLine))
+            {
+                MOVE_NEXT_LINE()
+                startLine = endLine;
+                endLine = -1;
+                glyphWidth = 0;
+                k = lastk;
+
+                state = !state;
+            }
+        }
+
+        if ((textOffsetX != 0) || (codepoint != ' ')) textOffsetX += glyphWidth;  // avoid leading spaces
+    }
+
+    out.size = Vector2{ textOffsetX, textOffsetY };
+#undef MOVE_NEXT_LINE
+}
+
+void draw_text_layout(const TextLayout& layout, Font font, Vector2 position, Color tint){
+    if(layout.glyphs.empty() || font.texture.id == 0) return;
+    float tex_w = (float)font.texture.width;
+    float tex_h = (float)font.texture.height;
+
+    rlSetTexture(font.texture.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for(const LayoutGlyph& g: layout.glyphs){
+        Color c = tint;
+        if(g.span >= 0){
+            c = layout.spans[g.span].color;
+            c.a = tint.a;
+        }
+        float x0 = position.x + g.dst.x;
+        float y0 = position.y + g.dst.y;
+        float x1 = x0 + g.dst.width;
+        float y1 = y0 + g.dst.height;
+        float u0 = g.src.x / tex_w;
+        float v0 = g.src.y / tex_h;
+        float u1 = (g.src.x + g.src.width) / tex_w;
+        float v1 = (g.src.y + g.src.height) / tex_h;
+        rlColor4ub(c.r, c.g, c.b, c.a);
+        rlTexCoord2f(u0, v0);
+        rlVertex2f(x0, y0);
+        rlTexCoord2f(u0, v1);
+        rlVertex2f(x0, y1);
+        rlTexCoord2f(u1, v1);
+        rlVertex2f(x1, y1);
+        rlTexCoord2f(u1, v0);
+        rlVertex2f(x1, y0);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+template<typename T>
+static void append_bytes(std::string& key, const T& value){
+    key.append((const char*)&value, sizeof(T));
+}
+
+const TextLayout& TextLayoutCache::get(Font font, std::string_view text, float width, float height, float font_size, float spacing, float line_spacing, bool limit_height, bool word_wrap){
+    std::string key;
+    key.reserve(text.size() + 48);
+    key.append(text);
+    key.push_back('\0');
+    append_bytes(key, font.texture.id);
+    append_bytes(key, font.baseSize);
+    append_bytes(key, font.glyphCount);
+    // glyphs of a dynamic font move when others are evicted
+    DynamicFont* dynamic = DynamicFont::find(font);
+    append_bytes(key, dynamic != nullptr ? dynamic->generation : 0);
+    append_bytes(key, width);
+    // the height only matters if the text is clipped
+    append_bytes(key, limit_height ? height : 0.0f);
+    append_bytes(key, font_size);
+    append_bytes(key, spacing);
+    append_bytes(key, line_spacing);
+    append_bytes(key, (char)(limit_height | word_wrap << 1));
+
+    tick++;
+    auto it = layouts.find(key);
+    if(it != layouts.end()){
+        it->second.last_used = tick;
+        return it->second;
+    }
+
+    if((int)layouts.size() >= max_layouts){
+        std::vector<int> ticks;
+        ticks.reserve(layouts.size());
+        for(auto& [_, layout]: layouts) ticks.push_back(layout.last_used);
+        std::nth_element(ticks.begin(), ticks.begin() + ticks.size() / 2, ticks.end());
+        int median = ticks[ticks.size() / 2];
+        for(auto e = layouts.begin(); e != layouts.end();){
+            if(e->second.last_used < median) e = layouts.erase(e);
+            else ++e;
+        }
+    }
+
+    TextLayout& layout = layouts[std::move(key)];
+    layout_text_boxed(layout, font, text, width, height, font_size, spacing, line_spacing, limit_height, word_wrap);
+    layout.last_used = tick;
+    return layout;
+}
+
+}   // namespace ct
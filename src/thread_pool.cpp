@@ -0,0 +1,75 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace ct{
+
+ThreadPool::ThreadPool(int worker_count): task(nullptr), task_count(0), next_index(0), running(0), generation(0), stopping(false){
+    for(int i=0; i<worker_count; i++){
+        workers.emplace_back([this](){ _worker_main(); });
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for(std::thread& t: workers) t.join();
+}
+
+// the lock is held on entry and on return, but not while running a task
+void ThreadPool::_run_indices(std::unique_lock<std::mutex>& lock){
+    while(next_index < task_count){
+        int index = next_index++;
+        lock.unlock();
+        (*task)(index);
+        lock.lock();
+    }
+}
+
+void ThreadPool::_worker_main(){
+    int seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true){
+        start_cv.wait(lock, [&](){ return stopping || generation != seen; });
+        if(stopping) return;
+        seen = generation;
+        running++;
+        _run_indices(lock);
+        running--;
+        if(running == 0) done_cv.notify_all();
+    }
+}
+
+void ThreadPool::parallel_for(int count, const std::function<void(int)>& f){
+    if(count <= 0) return;
+    if(workers.empty() || count == 1){
+        for(int i=0; i<count; i++) f(i);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    task = &f;
+    task_count = count;
+    next_index = 0;
+    generation++;
+    start_cv.notify_all();
+    _run_indices(lock);
+    // workers that have not woken up yet find no index left
+    done_cv.wait(lock, [&](){ return running == 0; });
+    task = nullptr;
+    task_count = 0;
+}
+
+ThreadPool& get_thread_pool(){
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    static ThreadPool pool(0);
+#else
+    // leave a core for the rest of the process, a few workers are enough for memory bound loops
+    static ThreadPool pool(std::clamp((int)std::thread::hardware_concurrency() - 1, 0, 7));
+#endif
+    return pool;
+}
+
+}   // namespace ct
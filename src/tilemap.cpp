@@ -0,0 +1,116 @@
+#include "tilemap.hpp"
+#include "rlgl.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ct{
+
+TilemapMesh::TilemapMesh(int width, int height, int grid_size, int chunk_size):
+    width(width), height(height), grid_size(grid_size), chunk_size(chunk_size){
+    chunks_x = (width + chunk_size - 1) / chunk_size;
+    chunks_y = (height + chunk_size - 1) / chunk_size;
+    chunks.resize(std::max(chunks_x * chunks_y, 1));
+}
+
+TileChunk* TilemapMesh::chunk_at(int cx, int cy){
+    // tiles with an offset may lie outside the map, keep them in the nearest chunk
+    int x = std::clamp(cx / chunk_size, 0, std::max(chunks_x - 1, 0));
+    int y = std::clamp(cy / chunk_size, 0, std::max(chunks_y - 1, 0));
+    return &chunks[y * chunks_x + x];
+}
+
+void TilemapMesh::add(int cx, int cy, int src_x, int src_y, int flips, Texture2D texture){
+    TileQuad q;
+    q.cx = cx;
+    q.cy = cy;
+    q.x0 = cx * grid_size;
+    q.y0 = cy * grid_size;
+    q.x1 = q.x0 + grid_size;
+    q.y1 = q.y0 + grid_size;
+    q.u0 = (float)src_x / texture.width;
+    q.v0 = (float)src_y / texture.height;
+    q.u1 = (float)(src_x + grid_size) / texture.width;
+    q.v1 = (float)(src_y + grid_size) / texture.height;
+    if(flips & 0b01) std::swap(q.u0, q.u1);
+    if(flips & 0b10) std::swap(q.v0, q.v1);
+    chunk_at(cx, cy)->quads.push_back(q);
+}
+
+void TilemapMesh::clear_cell(int cx, int cy){
+    std::vector<TileQuad>& quads = chunk_at(cx, cy)->quads;
+    quads.erase(std::remove_if(quads.begin(), quads.end(), [=](const TileQuad& q){
+        return q.cx == cx && q.cy == cy;
+    }), quads.end());
+}
+
+void TilemapMesh::clear(){
+    for(TileChunk& chunk: chunks) chunk.quads.clear();
+}
+
+int TilemapMesh::draw(SpriteBatch& batch, const Mat3x3& transform, Texture2D texture, float viewport_width, float viewport_height){
+    if(texture.id == 0) return 0;
+
+    // local pixels -> viewport pixels
+    Mat3x3 m;
+    PK_OBJ_GET(Mat3x3, batch.world_to_viewport).matmul(transform, m);
+    float a = m._11 / batch.pixel_per_unit;
+    float b = m._12 / batch.pixel_per_unit;
+    float c = m._21 / batch.pixel_per_unit;
+    float d = m._22 / batch.pixel_per_unit;
+    float tx = m._13;
+    float ty = m._23;
+    float det = a * d - b * c;
+    if(det == 0) return 0;
+
+    // bounds of the viewport in local pixels
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    const float corners[4][2] = {{0, 0}, {viewport_width, 0}, {0, viewport_height}, {viewport_width, viewport_height}};
+    for(auto& p: corners){
+        float x = p[0] - tx;
+        float y = p[1] - ty;
+        float lx = (d * x - b * y) / det;
+        float ly = (-c * x + a * y) / det;
+        min_x = std::min(min_x, lx);
+        min_y = std::min(min_y, ly);
+        max_x = std::max(max_x, lx);
+        max_y = std::max(max_y, ly);
+    }
+    // one cell of margin for tiles drawn with an offset
+    float chunk_px = (float)chunk_size * grid_size;
+    int x_begin = std::max((int)std::floor((min_x - grid_size) / chunk_px), 0);
+    int y_begin = std::max((int)std::floor((min_y - grid_size) / chunk_px), 0);
+    int x_end = std::min((int)std::floor((max_x + grid_size) / chunk_px), chunks_x - 1);
+    int y_end = std::min((int)std::floor((max_y + grid_size) / chunk_px), chunks_y - 1);
+
+    // recorded sprites go first, tiles are not sorted with them
+    batch.flush();
+    int drawn = 0;
+    rlSetTexture(texture.id);
+    rlBegin(RL_QUADS);
+    rlColor4ub(255, 255, 255, 255);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for(int y=y_begin; y<=y_end; y++){
+        for(int x=x_begin; x<=x_end; x++){
+            const TileChunk& chunk = chunks[y * chunks_x + x];
+            if(chunk.quads.empty()) continue;
+            // rlgl starts a new draw call by itself when its vertex buffer is full
+            for(const TileQuad& q: chunk.quads){
+                rlTexCoord2f(q.u0, q.v0);
+                rlVertex2f(a*q.x0 + b*q.y0 + tx, c*q.x0 + d*q.y0 + ty);
+                rlTexCoord2f(q.u0, q.v1);
+                rlVertex2f(a*q.x0 + b*q.y1 + tx, c*q.x0 + d*q.y1 + ty);
+                rlTexCoord2f(q.u1, q.v1);
+                rlVertex2f(a*q.x1 + b*q.y1 + tx, c*q.x1 + d*q.y1 + ty);
+                rlTexCoord2f(q.u1, q.v0);
+                rlVertex2f(a*q.x1 + b*q.y0 + tx, c*q.x1 + d*q.y0 + ty);
+            }
+            drawn++;
+        }
+    }
+    rlEnd();
+    rlSetTexture(0);
+    return drawn;
+}
+
+}   // namespace ct
@@ -2,7 +2,7 @@ import raylib as rl
 from _carrotlib import list_assets
 from typing import Iterable, Literal
 
-from ._resources import load_texture
+from ._resources import load_atlas_texture
 from ._renderer import Texture2D, SubTexture2D
 
 LoopType = Literal['forward', 'ping-pong'] | None
@@ -33,25 +33,27 @@ def load_framed_animation(path: str, speed: int, loop: LoopType = None):
     # │   ├── 2.png
     anim = load_framed_animation('assets/frames', 4)
     ```
+
+    Frames are packed into the texture atlas, see `load_atlas_texture`.
     """
     frames = []
     for frame in sorted(list_assets(path)):
-        frames.append(load_texture(frame))
+        frames.append(load_atlas_texture(frame))
     return FramedAnimation(frames, speed, loop)
 
 def load_framed_animation_atlas(path: str, tile_width: int, tile_height: int, tile_indices: Iterable[int], speed: int, loop: LoopType = None):
     """Load a framed animation from a texture atlas.
     The atlas should be tiled.
     """
-    main_tex = load_texture(path)
-    assert main_tex.width % tile_width == 0
-    assert main_tex.height % tile_height == 0
+    sheet = load_atlas_texture(path)
+    assert sheet.width % tile_width == 0
+    assert sheet.height % tile_height == 0
     frames = []
-    tiles_per_row = main_tex.width // tile_width
+    tiles_per_row = sheet.width // tile_width
     for i in tile_indices:
-        src_x = (i % tiles_per_row) * tile_width
-        src_y = (i // tiles_per_row) * tile_height
-        frames.append(SubTexture2D(main_tex, src_x, src_y, tile_width, tile_height))
+        src_x = sheet.src_x + (i % tiles_per_row) * tile_width
+        src_y = sheet.src_y + (i // tiles_per_row) * tile_height
+        frames.append(SubTexture2D(sheet.main_tex, src_x, src_y, tile_width, tile_height))
     return FramedAnimation(frames, speed, loop)
 
 
@@ -1,7 +1,7 @@
 import raylib as rl
 from typing import TypeVar, TYPE_CHECKING
 from linalg import vec2, mat3x3
-from _carrotlib import _bake_global_light, _bake_point_light
+from _carrotlib import LightmapBaker, _load_light_target, _gen_light_falloff
 
 from ._colors import Colors
 from ._node import Node
@@ -10,22 +10,80 @@ from . import g as _g
 T = TypeVar('T', bound='Light2D')
 
 class Lightmap:
-    def __init__(self, width: int, height: int) -> None:
-        self.image = rl.GenImageColor(width, height, Colors.Blank)
-        rl.ImageFormat(self.image.addr(), rl.PIXELFORMAT_UNCOMPRESSED_R32G32B32A32)
-        self.texture = rl.LoadTextureFromImage(self.image)
+    """Screen sized light texture sampled by `DiffuseMaterial`.
+
+    By default lights are baked on the CPU, only the texels of lights that moved or changed
+    are baked and uploaded again. With `gpu=True` they are drawn as additive quads into a
+    render texture instead.
+
+    Lighting is smooth, a `divisor` greater than 1 bakes one texel per `divisor` pixels and
+    `DiffuseMaterial` upsamples it bilinearly.
+
+    With `compact=True` the CPU lightmap is uploaded as RGBM in an RGBA8 texture, a quarter of
+    the memory and bandwidth of float texels. Lights saturate at `RGBM_RANGE` and the alpha of
+    lights is ignored.
+    """
+    FALLOFF_SIZE = 64
+    RGBM_RANGE = 8.0
+
+    def __init__(self, width: int, height: int, gpu: bool = False, divisor: int = 1, compact: bool = False) -> None:
+        assert divisor >= 1
+        if gpu and compact:
+            raise ValueError('compact lightmaps are baked on the CPU')
+        self.gpu = gpu
+        self.divisor = divisor
+        # 0 for float texels, see `diffuse.frag`
+        self.rgbm_range = self.RGBM_RANGE if compact else 0.0
+        # the last row and column may extend past the viewport
+        w = (width + divisor - 1) // divisor
+        h = (height + divisor - 1) // divisor
+        self.size = vec2(w, h)
+        # viewport coordinates -> lightmap coordinates, see `diffuse.frag`
+        self.uv_scale = vec2(width / (w * divisor), height / (h * divisor))
+        if gpu:
+            self.image = None
+            self.target = _load_light_target(w, h)
+            self.texture = self.target.texture
+            falloff = _gen_light_falloff(self.FALLOFF_SIZE)
+            self.falloff = rl.LoadTextureFromImage(falloff)
+            rl.UnloadImage(falloff)
+            rl.SetTextureFilter(self.falloff, rl.TEXTURE_FILTER_BILINEAR)
+            rl.SetTextureWrap(self.falloff, rl.TEXTURE_WRAP_CLAMP)
+        else:
+            self.image = rl.GenImageColor(w, h, Colors.Blank)
+            if compact:
+                # RGBA8, the format of `GenImageColor()`
+                self.texture = rl.LoadTextureFromImage(self.image)
+                rl.ImageFormat(self.image.addr(), rl.PIXELFORMAT_UNCOMPRESSED_R32G32B32A32)
+            else:
+                rl.ImageFormat(self.image.addr(), rl.PIXELFORMAT_UNCOMPRESSED_R32G32B32A32)
+                self.texture = rl.LoadTextureFromImage(self.image)
+        # upsampled by hand in `diffuse.frag`, the edges must not wrap around
+        rl.SetTextureWrap(self.texture, rl.TEXTURE_WRAP_CLAMP)
+        self._baker = LightmapBaker(self.rgbm_range)
         # lights
         self.lights = []
 
     def update(self):
-        rl.ImageClearBackground(self.image.addr(), Colors.Black)
+        items = []
         for light in self.lights:
-            light._bake(self.image)
-        rl.UpdateTexture(self.texture, self.image.data)
+            light._collect(items)
+        if self.gpu:
+            self._baker.render(self.target, self.falloff, items, self.divisor)
+        else:
+            self._baker.bake(self.image.addr(), self.texture, items, self.divisor)
+
+    def invalidate(self):
+        """Bake all texels on the next update."""
+        self._baker.invalidate()
 
     def destroy(self):
-        rl.UnloadTexture(self.texture)
-        rl.UnloadImage(self.image)
+        if self.gpu:
+            rl.UnloadTexture(self.falloff)
+            rl.UnloadRenderTexture(self.target)
+        else:
+            rl.UnloadTexture(self.texture)
+            rl.UnloadImage(self.image)
 
 class Light2D(Node):
     color: rl.Color = Colors.White
@@ -36,7 +94,8 @@ class Light2D(Node):
         self.lightmap = lightmap or _g.default_lightmap
         self.lightmap.lights.append(self)
 
-    def _bake(self, image: rl.Image) -> None:
+    def _collect(self, items: list[tuple]) -> None:
+        """append the lights to bake, see `_bake_lights()`"""
         raise NotImplementedError
     
     def on_destroy(self):
@@ -47,17 +106,17 @@ class Light2D(Node):
 
 
 class GlobalLight2D(Light2D):
-    def _bake(self, image: rl.Image) -> None:
-        _bake_global_light(image.addr(), self.color, self.intensity)
+    def _collect(self, items: list[tuple]) -> None:
+        items.append((self.color, self.intensity))
 
 
 class PointLight2D(Light2D):
     radius: int = 1
 
-    def _bake(self, image: rl.Image) -> None:
+    def _collect(self, items: list[tuple]) -> None:
         screen_pos = _g.world_to_viewport.transform_point(self.global_position)
         x, y = round(screen_pos.x), round(screen_pos.y)
-        _bake_point_light(image.addr(), self.color, self.intensity, x, y, self.radius)
+        items.append((self.color, self.intensity, x, y, self.radius, None))
 
 
 if TYPE_CHECKING:
@@ -68,7 +127,7 @@ class ParticleLight2D(Light2D):
     parent: 'Particles'
     radius: int = 1
 
-    def _bake(self, image: rl.Image) -> None:
+    def _collect(self, items: list[tuple]) -> None:
         t = mat3x3.identity()
         for p in self.parent._particles:
             t.copy_trs_(p.position, p.rotation, p.scale)
@@ -85,4 +144,4 @@ class ParticleLight2D(Light2D):
             scale_ratio = t._s().length() / p._init_t._s().length()
             radius = round(self.radius * scale_ratio)
             intensity = color.a / 255 * self.intensity
-            _bake_point_light(image.addr(), color, intensity, x, y, radius)
\ No newline at end of file
+            items.append((color, intensity, x, y, radius, None))
\ No newline at end of file
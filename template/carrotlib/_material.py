@@ -1,5 +1,5 @@
 import raylib as rl
-from _carrotlib import GRAPHICS_API_OPENGL_33, GRAPHICS_API_OPENGL_ES2, GRAPHICS_API_OPENGL_ES3, load_text_asset
+from _carrotlib import GRAPHICS_API_OPENGL_33, GRAPHICS_API_OPENGL_ES2, GRAPHICS_API_OPENGL_ES3, load_text_asset, MaterialState
 
 from ._light import Lightmap
 from . import g as _g
@@ -73,12 +73,15 @@ return _mix(1.055 * pow(rgb, vec3(1.0 / 2.4)) - 0.055,
 
 class Material:
     cached_shaders: dict[type, rl.Shader] = {}
+    cached_locations: dict[tuple[type, str], int] = {}
 
     def __init__(self):
         cls = type(self)
         if cls not in self.cached_shaders:
             self.cached_shaders[cls] = rl.LoadShaderFromMemory(*_compile_shader(cls.vert(), cls.frag()))
         self.shader = self.cached_shaders[cls]
+        # textures and uniforms of this material, recorded with its sprites
+        self._state = MaterialState(self.shader)
 
     @classmethod
     def vert(cls) -> str | None:
@@ -88,14 +91,51 @@ class Material:
     def frag(cls) -> str | None:
         return None
     
+    def set_texture(self, name: str, texture: rl.Texture2D):
+        """Set a sampler of the shader for the sprites of this material."""
+        self._state.set_texture(self._location(name), texture)
+
+    def set_uniform(self, name: str, value):
+        """Set a `float`, `vec2`, `vec3` or `vec4` uniform of the shader for the sprites of this material.
+
+        Materials of the same class share the shader, so do not set values on the shader directly.
+        """
+        self._state.set_uniform(self._location(name), value)
+
+    def _location(self, name: str) -> int:
+        key = (type(self), name)
+        loc = self.cached_locations.get(key)
+        if loc is None:
+            loc = rl.GetShaderLocation(self.shader, name)
+            self.cached_locations[key] = loc
+        return loc
+
+    def _apply(self):
+        """Set the textures and uniforms of this material, called whenever it is bound.
+
+        Override it in materials with per-material values and set them with `set_texture()`
+        and `set_uniform()`. Both `with material:` and sprites bind through it.
+        """
+        pass
+
     def __enter__(self):
-        rl.BeginShaderMode(self.shader)
+        self._apply()
+        _g.sprite_batch.set_material(self._state)
         return self
     
     def __exit__(self, *args):
-        rl.EndShaderMode()
+        _g.sprite_batch.reset_shader()
         return self
 
+    def _bind(self):
+        """Bind the shader for the following sprites without a `with` scope.
+
+        It stays bound until another material is used, so consecutive sprites
+        of the same material are drawn without flushing the render batch.
+        """
+        self._apply()
+        _g.sprite_batch.set_material(self._state, True)
+
 
 class UnlitMaterial(Material):
     """Material without lighting. It displays the texture as is."""
@@ -113,7 +153,8 @@ class DiffuseMaterial(Material):
     def __init__(self, lightmap: 'Lightmap' = None):
         super().__init__()
         self.lightmap = lightmap or _g.default_lightmap
-        self._loc_lightmap = rl.GetShaderLocation(self.shader, "texture1")
+        # the lightmap whose values are in `_state`
+        self._applied_lightmap = None
 
     @classmethod
     def vert(cls) -> str:
@@ -123,10 +164,16 @@ class DiffuseMaterial(Material):
     def frag(cls) -> str:
         return load_text_asset("carrotlib/assets/shaders/diffuse.frag")
 
-    def __enter__(self):
-        super().__enter__()
-        rl.SetShaderValueTexture(self.shader, self._loc_lightmap, self.lightmap.texture)
-        return self
+    def _apply(self):
+        # called for every sprite, a lightmap never changes its texture or size
+        lightmap = self.lightmap
+        if lightmap is self._applied_lightmap:
+            return
+        self.set_texture("texture1", lightmap.texture)
+        self.set_uniform("lightmapSize", lightmap.size)
+        self.set_uniform("lightmapScale", lightmap.uv_scale)
+        self.set_uniform("lightmapRGBMRange", lightmap.rgbm_range)
+        self._applied_lightmap = lightmap
 
 
 class PureColorMaterial(Material):
@@ -137,3 +184,13 @@ class PureColorMaterial(Material):
     @classmethod
     def frag(cls) -> str:
         return load_text_asset("carrotlib/assets/shaders/pure_color.frag")
+
+
+class SDFTextMaterial(Material):
+    """Material for text of SDF fonts, see `load_font(path, sdf=True)`.
+
+    It is bound by the text drawing functions, you do not need to use it directly.
+    """
+    @classmethod
+    def frag(cls) -> str:
+        return load_text_asset("carrotlib/assets/shaders/sdf_text.frag")
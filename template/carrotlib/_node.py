@@ -3,7 +3,6 @@ import raylib as rl
 import box2d
 import math
 from typing import Literal, Iterable
-from __builtins import next
 
 from _carrotlib import fast_apply
 from . import g as _g
@@ -17,7 +16,6 @@ class Node:
     def on_box2d_pre_step(self): pass
     def on_box2d_post_step(self): pass
 
-    parent: 'Node'
     children: dict[str, 'Node']
 
     @property
@@ -28,27 +26,85 @@ class Node:
         """Create a new node with the given name and parent."""
         # private fields
         self._name = name or hex(id(self))
-        self._coroutines = []           # running coroutines
-        self._living_coroutines = []    # living coroutines
         self._state = 0                 # unready -> ready -> destroyed
-        self._cached_transform = mat3x3.identity()
         self._raii_objects = []
-        # transform
-        self.position = vec2(0, 0)
-        self.rotation = 0           # in radians
-        self.scale = vec2(1, 1)
+        self._ui_layer = None           # cached container that draws this node, see `Container.cached`
+        # transform (see `position`, `rotation` and `scale` properties)
+        self._position = vec2(0, 0)
+        self._rotation = 0          # in radians
+        self._scale = vec2(1, 1)
         # hierarchy
         self.children = {}
         # settings
-        self.z_index = 0
-        self.enabled = True
+        self._z_index = 0
+        self._enabled = True
         self.tags = []
 
-        self.parent = parent or _g.root
-        if self.parent is not None:
-            if self._name in self.parent.children:
-                raise ValueError(f'duplicated child name {self._name!r}')
-            self.parent.children[self._name] = self
+        parent = parent or _g.root
+        if parent is not None and self._name in parent.children:
+            raise ValueError(f'duplicated child name {self._name!r}')
+        # slot in the native transform store, -1 after destroyed
+        self._tid = _g.scene_graph.alloc(self, self._position, self._scale, -1 if parent is None else parent._tid)
+        self._parent = parent
+        if parent is not None:
+            parent.children[self._name] = self
+
+    @property
+    def parent(self) -> 'Node':
+        return self._parent
+
+    @parent.setter
+    def parent(self, value: 'Node'):
+        self._parent = value
+        _g.scene_graph.set_parent(self._tid, -1 if value is None else value._tid)
+
+    @property
+    def z_index(self) -> int | float:
+        """A larger z-index means the node will be rendered on top of others."""
+        return self._z_index
+
+    @z_index.setter
+    def z_index(self, value: int | float):
+        self._z_index = value
+        _g.scene_graph.set_z_index(self._tid, value)
+
+    @property
+    def enabled(self) -> bool:
+        """Whether this node and its children take part in update and render."""
+        return self._enabled
+
+    @enabled.setter
+    def enabled(self, value: bool):
+        self._enabled = value
+        _g.scene_graph.set_enabled(self._tid, value)
+
+    @property
+    def position(self) -> vec2:
+        """Local position. The vec2 object is owned by the node, so it can be modified in place."""
+        return self._position
+
+    @position.setter
+    def position(self, value: vec2):
+        self._position.copy_(value)
+
+    @property
+    def rotation(self) -> float:
+        """Local rotation in radians."""
+        return self._rotation
+
+    @rotation.setter
+    def rotation(self, value: float):
+        self._rotation = value
+        _g.scene_graph.set_rotation(self._tid, value)
+
+    @property
+    def scale(self) -> vec2:
+        """Local scale. The vec2 object is owned by the node, so it can be modified in place."""
+        return self._scale
+
+    @scale.setter
+    def scale(self, value: vec2):
+        self._scale.copy_(value)
 
     @property
     def state(self) -> Literal[0, 1, 2]:
@@ -99,12 +155,9 @@ class Node:
 
         A larger z-index means the node will be rendered on top of others.
         """
-        res = self.z_index
-        node = self
-        while node.parent is not None:
-            node = node.parent
-            res += node.z_index
-        return res
+        if self._tid == -1:
+            return self._z_index
+        return _g.scene_graph.total_z_index(self._tid)
 
     def get_node(self, path: str) -> 'Node':
         """Get a child node by its relative path."""
@@ -120,42 +173,31 @@ class Node:
         return b2_body
     
     def transform(self) -> mat3x3:
-        """Get the transform matrix from local space to global space."""
-        if self.parent is None:
-            return mat3x3.identity()
-        t = self.parent.transform()
-        self._cached_transform.copy_trs_(self.position, self.rotation, self.scale)
-        t.matmul(self._cached_transform, out=t)
-        return t
+        """Get the transform matrix from local space to global space.
+
+        The matrix is cached by the native scene graph and only recomputed
+        when this node or one of its ancestors has changed.
+        """
+        return _g.scene_graph.transform(self._tid)
 
     def _ready(self):
         # call on_ready only once
         if self._state == 0:
             self.on_ready()
             self._state = 1
+            _g.scheduler.set_ready(self._tid)
 
     def _update(self):
-        if self._state != 1:
-            return
-        self.on_update()
-        # update coroutines
-        if self._coroutines:
-            for coroutine in self._coroutines:
-                # None means a coroutine was stopped by user
-                # we cannot remove it immediately because it will break the loop
-                if coroutine is None:
-                    continue
-                if next(coroutine) is not StopIteration:
-                    self._living_coroutines.append(coroutine)
-            self._coroutines, self._living_coroutines = self._living_coroutines, self._coroutines
-            self._living_coroutines.clear()
+        if self._state == 1:
+            self.on_update()
 
     def _render(self):
         if self._state == 1:
             self.on_render()
 
     def _render_ui(self):
-        if self._state == 1:
+        # nodes of a cached container are drawn into its layer by the container
+        if self._state == 1 and self._ui_layer is None:
             self.on_render_ui()
 
     def _destroy(self):
@@ -166,6 +208,9 @@ class Node:
         self.stop_all_coroutines()
         for obj in self._raii_objects:
             obj.destroy()
+        _g.scheduler.free(self._tid)
+        _g.scene_graph.free(self._tid)
+        self._tid = -1
 
     def apply(self, f):
         """Apply a function to this node and all its children recursively."""
@@ -206,21 +251,38 @@ class Node:
         _g.root.start_coroutine(_DestroyLater(delay, self))
     
     def start_coroutine(self, coroutine: Iterable):
-        """Start a coroutine on this node."""
-        self._coroutines.append(coroutine)
+        """Start a coroutine on this node.
+
+        The coroutine is resumed once per frame after `on_update`, while this node is ready and active.
+        Yield a `WaitForSeconds` to sleep without being resumed until it expires.
+        """
+        _g.scheduler.start(self._tid, coroutine)
         return coroutine
 
     def stop_coroutine(self, coroutine: Iterable):
         """Stop a coroutine on this node."""
-        for i in range(len(self._coroutines)):
-            if self._coroutines[i] is coroutine:
-                self._coroutines[i] = None
-                break
+        _g.scheduler.stop(self._tid, coroutine)
 
     def stop_all_coroutines(self):
         """Stop all coroutines on this node."""
-        for i in range(len(self._coroutines)):
-            self._coroutines[i] = None
+        _g.scheduler.stop_all(self._tid)
+
+    def coroutine_count(self) -> int:
+        """Get the number of running coroutines on this node."""
+        return _g.scheduler.count(self._tid)
+
+    @property
+    def time_scale(self) -> float:
+        """Speed of this node's clock, which drives its `WaitForSeconds` and tweens."""
+        return _g.scheduler.get_time_scale(self._tid)
+
+    @time_scale.setter
+    def time_scale(self, value: float):
+        _g.scheduler.set_time_scale(self._tid, value)
+
+    def time(self) -> float:
+        """Get the scaled time of this node in seconds."""
+        return _g.scheduler.time(self._tid)
 
 
 def get_node(path: str) -> Node:
@@ -243,6 +305,10 @@ def build_scene_tree(tree: dict, locals: dict, root: Node = None):
 
 class WaitForSeconds:
     """A coroutine that waits for a number of seconds.
+
+    It yields itself once, then the scheduler parks the coroutine until
+    `seconds` of the node's time have passed. Driven outside the scheduler,
+    it measures the frame time instead.
     
     Example:
     ```python
@@ -254,16 +320,23 @@ class WaitForSeconds:
     """
     def __init__(self, seconds: float):
         self._seconds = seconds
+        self._parked = False        # set by the scheduler
+        self._yielded = False
         self._t = 0
 
     def __iter__(self):
         return self
     
     def __next__(self):
-        self._t += rl.GetFrameTime()
-        if self._t >= self._seconds:
+        if self._parked or self._seconds <= 0:
             return StopIteration
-        return None
+        if self._yielded:
+            # not parked by the scheduler
+            self._t += rl.GetFrameTime()
+            if self._t >= self._seconds:
+                return StopIteration
+        self._yielded = True
+        return self
     
 class WaitForEndOfFrame:
     """A coroutine that waits for the end of the current frame."""
@@ -282,4 +355,5 @@ class _DestroyLater(WaitForSeconds):
         obj = super().__next__()
         if obj is StopIteration:
             self.node.destroy()
-            return obj
\ No newline at end of file
+        # the parked `WaitForSeconds` tells the scheduler how long to wait
+        return obj
\ No newline at end of file
@@ -1,5 +1,6 @@
 from linalg import *
 import raylib as rl
+from _carrotlib import prepare_text, is_sdf_font, _set_sdf_text_uniforms
 
 from ._colors import Colors
 from ._constants import PIVOT_CENTER
@@ -25,54 +26,37 @@ rl.Texture2D.__repr__ = Texture2D__repr__
 
 
 def draw_texture(transform: mat3x3, tex: rl.Texture2D, src_rect: rl.Rectangle=None, flip_x=False, flip_y=False, color: rl.Color = None, origin: vec2 = None):
-    if _g.is_rendering_ui:
-        pos = transform._t()
-        rot = transform._r()
-        scale = transform._s()
-    else:
-        _g.world_to_viewport.matmul(transform, out=transform)
-        pos = transform._t()
-        rot = transform._r()
-        scale = transform._s() / _g.PIXEL_PER_UNIT
-
-    src_rect = src_rect or rl.Rectangle(0, 0, tex.width, tex.height)
-
-    dest_width = src_rect.width * scale.x
-    dest_height = src_rect.height * scale.y
-
-    if flip_x:
-        src_rect.width *= -1
-    if flip_y:
-        src_rect.height *= -1
-
-    if origin is None:
-        origin = vec2(0.5*dest_width, 0.5*dest_height)
-    else:
-        origin = vec2(origin.x*dest_width, origin.y*dest_height)
-
-    dest_rect = rl.Rectangle(pos.x, pos.y, dest_width, dest_height)
-    rl.DrawTexturePro(
-        tex,
-        src_rect,
-        dest_rect,
-        origin,
-        rot * 57.295779512896,       # convert rad to deg
-        color or Colors.White,
-    )
+    """draw a texture through the native sprite batch, with the current shader"""
+    _g.sprite_batch.draw(transform, tex, src_rect, flip_x, flip_y, color, origin, _g.is_rendering_ui)
+
+def _begin_text(font: rl.Font, font_size: float) -> bool:
+    """bind the SDF text material if `font` is an SDF font, returns True if it was bound"""
+    if not is_sdf_font(font):
+        return False
+    shader = _g.sdf_text_material.shader
+    _g.sprite_batch.set_shader(shader)
+    _set_sdf_text_uniforms(shader, font, font_size)
+    return True
 
 def draw_text(font: rl.Font, pos: vec2, text: str, font_size: int, color: rl.Color, spacing: int = 0, line_spacing: int = 0, origin: vec2 = None):
     """draw text in world space"""
+    _g.sprite_batch.flush()
     if not _g.is_rendering_ui:
         trans = _g.world_to_viewport
         pos = trans.transform_point(pos)
     origin = origin or PIVOT_CENTER
+    prepare_text(font, text)
     rl.SetTextLineSpacing(line_spacing + font_size)
     size = rl.MeasureTextEx(font, text, font_size, spacing)
     pos -= size * origin
+    sdf = _begin_text(font, font_size)
     rl.DrawTextEx(font, text, pos, font_size, spacing, color)
+    if sdf:
+        _g.sprite_batch.reset_shader()
 
 
 def draw_circle(center: vec2, radius: float, color: rl.Color, solid=True):
+    _g.sprite_batch.flush()
     if not _g.is_rendering_ui:
         trans = _g.world_to_viewport
         center = trans.transform_point(center)
@@ -84,6 +68,7 @@ def draw_circle(center: vec2, radius: float, color: rl.Color, solid=True):
 
 
 def draw_rect(rect: rl.Rectangle, color: rl.Color = None, origin: vec2 = None, solid=True, line_thick=1):
+    _g.sprite_batch.flush()
     rect = rect.copy()
     if not _g.is_rendering_ui:
         trans = _g.world_to_viewport
@@ -102,6 +87,7 @@ def draw_rect(rect: rl.Rectangle, color: rl.Color = None, origin: vec2 = None, s
         rl.DrawRectangleLinesEx(rect, line_thick, color or Colors.White)
 
 def draw_line(begin: vec2, end: vec2, thick: float, color: rl.Color):
+    _g.sprite_batch.flush()
     if not _g.is_rendering_ui:
         trans = _g.world_to_viewport
         begin = trans.transform_point(begin)
@@ -109,6 +95,7 @@ def draw_line(begin: vec2, end: vec2, thick: float, color: rl.Color):
     rl.DrawLineEx(begin, end, thick, color)
 
 def draw_line_bezier(begin: vec2, end: vec2, thick: float, color: rl.Color):
+    _g.sprite_batch.flush()
     if not _g.is_rendering_ui:
         trans = _g.world_to_viewport
         begin = trans.transform_point(begin)
@@ -1,8 +1,10 @@
 from typing import Generic, TypeVar
 import raylib as rl
 
-from _carrotlib import _get_cjk_codepoints
+import json
+from _carrotlib import load_text_asset, TextureAtlas, DynamicFont
 from . import g as _g
+from ._renderer import SubTexture2D
 
 T = TypeVar("T")
 
@@ -24,10 +26,15 @@ class ResourceLoader(Generic[T]):
             self.f_unload(res)
         self.cache.clear()
 
-def _load_font_cjk(path: str) -> rl.Font:
-    p_data, count = _get_cjk_codepoints()
-    UNSCALING = 8
-    return rl.LoadFontEx(path, _g.default_font_size * UNSCALING, p_data, count)
+# SDF glyphs scale to any size, they are generated once at this size
+SDF_FONT_SIZE = 32
+
+def _load_font_cjk(path: str, texture_size: int, sdf: bool) -> DynamicFont:
+    # glyphs are rasterized on first use, so only the glyphs on screen take texture memory
+    if sdf:
+        return DynamicFont(path, SDF_FONT_SIZE, texture_size, True)
+    UNSCALING = 4
+    return DynamicFont(path, _g.default_font_size * UNSCALING, texture_size)
 
 def _load_texture_scaled(path: str, scale: float):
     image = rl.LoadImage(path)
@@ -42,23 +49,88 @@ def _load_square_texture(size: int):
     rl.UnloadImage(image)
     return texture
 
+# written by scripts/prepack_atlas.py at build time
+PREPACKED_ATLAS_MANIFEST = 'prepacked_atlas/manifest.json'
+
+_atlas: TextureAtlas = None
+
+def _get_atlas() -> TextureAtlas:
+    global _atlas
+    if _atlas is None:
+        _atlas = TextureAtlas()
+        try:
+            manifest = json.loads(load_text_asset(PREPACKED_ATLAS_MANIFEST))
+        except IOError:
+            manifest = None
+        if manifest is not None:
+            for page_path in manifest['pages']:
+                image = rl.LoadImage(page_path)
+                _atlas.add_page(image)
+                rl.UnloadImage(image)
+            for name, (page, x, y, w, h) in manifest['entries'].items():
+                _atlas.set_entry(name, page, x, y, w, h)
+    return _atlas
+
+def _unload_atlas():
+    global _atlas
+    if _atlas is not None:
+        _atlas.unload()
+        _atlas = None
+
+def _load_atlas_texture(path: str) -> SubTexture2D:
+    atlas = _get_atlas()
+    entry = atlas.find(path)
+    if entry is None:
+        image = rl.LoadImage(path)
+        entry = atlas.add(path, image)
+        rl.UnloadImage(image)
+    if entry is None:
+        # larger than a page
+        texture = load_texture(path)
+        return SubTexture2D(texture, 0, 0, texture.width, texture.height)
+    page, x, y, w, h = entry
+    return SubTexture2D(atlas.page_texture(page), x, y, w, h)
+
 # You should not modify cached resources directly!!
 load_texture = ResourceLoader[rl.Texture2D](rl.LoadTexture, rl.UnloadTexture)
+# the atlas owns the pages, they are unloaded by `_unload_atlas()`
+load_atlas_texture = ResourceLoader[SubTexture2D](_load_atlas_texture, lambda _: None)
 load_texture_scaled = ResourceLoader[rl.Texture2D](_load_texture_scaled, rl.UnloadTexture)
 load_square_texture = ResourceLoader[rl.Texture2D](_load_square_texture, rl.UnloadTexture)
 
-load_font_cjk = ResourceLoader[rl.Font](_load_font_cjk, rl.UnloadFont)
-load_font = ResourceLoader[rl.Font](rl.LoadFont, rl.UnloadFont)
+_load_dynamic_font = ResourceLoader[DynamicFont](_load_font_cjk, DynamicFont.unload)
+
+def load_font_cjk(path: str, texture_size: int = 2048, sdf: bool = False) -> rl.Font:
+    """Load a font whose glyphs are rasterized when they are first drawn.
+
+    `texture_size` is the memory budget, the least recently used glyphs are evicted when it is full.
+    If `sdf` is True, glyphs are signed distance fields that stay sharp at any size.
+    """
+    return _load_dynamic_font(path, texture_size, sdf).font
+
+_load_font = ResourceLoader[rl.Font](rl.LoadFont, rl.UnloadFont)
+
+def load_font(path: str, sdf: bool = False) -> rl.Font:
+    """Load a font with the glyphs of printable ASCII.
+
+    If `sdf` is True, glyphs are signed distance fields that stay sharp at any size.
+    They are generated once and kept in the caches directory.
+    """
+    if sdf:
+        return _load_dynamic_font(path, 1024, True).font
+    return _load_font(path)
 load_sound = ResourceLoader[rl.Sound](rl.LoadSound, rl.UnloadSound)
 load_image = ResourceLoader[rl.Image](rl.LoadImage, rl.UnloadImage)
 
 def _unload_all_resources():
+    load_atlas_texture.unload_all()
+    _unload_atlas()
     load_texture.unload_all()
     load_texture_scaled.unload_all()
     load_square_texture.unload_all()
     
-    load_font_cjk.unload_all()
-    load_font.unload_all()
+    _load_dynamic_font.unload_all()
+    _load_font.unload_all()
     load_sound.unload_all()
     load_image.unload_all()
 
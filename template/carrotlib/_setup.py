@@ -5,17 +5,17 @@ import raylib as rl
 
 import imgui
 
-from _carrotlib import fast_apply, GRAPHICS_API_OPENGL_33, GRAPHICS_API_OPENGL_ES2, GRAPHICS_API_OPENGL_ES3, _request_hot_reload
+from _carrotlib import fast_apply, fast_apply_overridden, SceneGraph, Scheduler, Profiler, SpriteBatch, GRAPHICS_API_OPENGL_33, GRAPHICS_API_OPENGL_ES2, GRAPHICS_API_OPENGL_ES3, _request_hot_reload
 
 from . import g
-from ._node import Node
-from .controls import Control
+from ._node import Node, WaitForSeconds
+from .controls import Control, _update_ui_layers
 from ._renderer import DebugDraw
 from ._sound import _unload_all_sound_aliases, _update_managed_sounds_coro, _count_managed_sounds
 from ._resources import _unload_all_resources
 from .debug import DebugWindow
 from ._viewport import get_mouse_position
-from ._material import UnlitMaterial
+from ._material import UnlitMaterial, SDFTextMaterial
 
 rl.SetTraceLogLevel(rl.LOG_WARNING)
 
@@ -40,6 +40,28 @@ class Game:
     def title(self):
         return "Game"
 
+    @property
+    def physics_hz(self) -> float:
+        """Fixed physics rate, `0` steps physics once per frame with the frame time.
+
+        Fixed steps do not line up with frames, override it only if bodies are drawn at
+        `Body.interpolated_position/rotation`, or they stutter.
+        """
+        return 0
+
+    @property
+    def physics_max_substeps(self) -> int:
+        """Max physics steps per frame, the rest is dropped after a frame spike."""
+        return 4
+
+    @property
+    def deferred_rendering(self) -> bool:
+        """Record sprites of the render pass and draw them sorted by (z, material, texture).
+
+        Sprites of an equal total z-index may be reordered to save shader and texture switches.
+        """
+        return True
+
     def on_ready(self):
         if not rl.IsWindowReady():
             rl.InitWindow(self.window_size[0], self.window_size[1], self.title)
@@ -79,9 +101,6 @@ class Game:
 
         #############################################
         # temporary variables
-        self.all_nodes = []
-        self.all_nodes__append = self.all_nodes.append
-        self.node_sort_key = lambda n: n.total_z_index()
         self.interactable_controls = []
 
         self.PIXEL_UNIT_TRANSFORM = mat3x3.trs(
@@ -91,83 +110,113 @@ class Game:
                 )
         #############################################
         g.rl_camera_2d = rl.Camera2D(vec2(0,0), vec2(0,0), 0, g.viewport_scale)
+        g.profiler = Profiler(240)
+        g.sprite_batch = SpriteBatch(g.world_to_viewport, g.PIXEL_PER_UNIT)
+        g.scene_graph = SceneGraph()
+        g.scheduler = Scheduler(g.scene_graph, WaitForSeconds)
         g.root = Node('root')
         g.b2_world = box2d.World()
         g.b2_world.set_debug_draw(DebugDraw())
+        g.b2_world.set_fixed_step(self.physics_hz, self.physics_max_substeps)
         g.debug_window = DebugWindow()
         g.default_font = rl.GetFontDefault()
         g.default_font_size = 20
         g.default_material = UnlitMaterial()
+        g.sdf_text_material = SDFTextMaterial()
         g.root.start_coroutine(_update_managed_sounds_coro())
 
     def on_update(self):
-        all_nodes: list[Node] = self.all_nodes
-        all_nodes__append = self.all_nodes__append
-        node_sort_key = self.node_sort_key
+        scene_graph = g.scene_graph
+        profiler = g.profiler
         interactable_controls: list[Control] = self.interactable_controls
 
-        all_nodes.clear()
-        g.root.apply(all_nodes__append)
-        fast_apply(Node._ready, all_nodes)
+        profiler.new_frame()
+        g.sprite_batch.reset_stats()
+
+        # persistent pre-order lists, only rebuilt when the hierarchy changes
+        # NOTE: these lists are shared with the scene graph, do not modify them
+        with profiler.scope('ready'):
+            all_nodes: list[Node] = scene_graph.flatten(g.root._tid, False)
+            fast_apply(Node._ready, all_nodes)
 
         # 1. physics update
-        g.b2_world.step(rl.GetFrameTime(), 6, 2)
+        # fixed-step if `physics_hz` is set, see its docstring
+        with profiler.scope('physics'):
+            g.b2_world.step(rl.GetFrameTime(), 6, 2)
 
         # 2. input events
-        all_nodes.clear()
-        g.root.apply_enabled(all_nodes__append)
-
-        interactable_controls.clear()
-        g.hovered_control = None
-
-        for node in all_nodes:
-            if isinstance(node, Control) and node.interactable and node._state == 1:
-                interactable_controls.append(node)
-        # make the most recently rendered control on top
-        interactable_controls.reverse()
-        for c in interactable_controls:
-            if rl.CheckCollisionPointRec(get_mouse_position(), c.global_rect()):
-                g.hovered_control = c
-                break
+        with profiler.scope('input'):
+            enabled_nodes: list[Node] = scene_graph.flatten(g.root._tid, True)
+
+            interactable_controls.clear()
+            g.hovered_control = None
+
+            for node in enabled_nodes:
+                if isinstance(node, Control) and node.interactable and node._state == 1:
+                    interactable_controls.append(node)
+            # make the most recently rendered control on top
+            interactable_controls.reverse()
+            for c in interactable_controls:
+                if rl.CheckCollisionPointRec(get_mouse_position(), c.global_rect()):
+                    g.hovered_control = c
+                    break
 
         # 3. update
-        fast_apply(Node._update, all_nodes)
+        # nodes that keep the no-op `Node.on_update` are skipped in C++
+        with profiler.scope('update'):
+            fast_apply_overridden(Node._update, Node, 'on_update', enabled_nodes)
+        # resume coroutines that are ready or whose wait has expired
+        with profiler.scope('coroutines'):
+            g.scheduler.update(rl.GetFrameTime())
 
         # 4. render
-        # update world_to_viewport
-        self.PIXEL_UNIT_TRANSFORM.matmul(g.world_to_camera, out=g.world_to_viewport)
-
-        if g.default_lightmap:
-            g.default_lightmap.update()
-
-        rl.BeginDrawing()
-        rl.BeginMode2D(g.rl_camera_2d)
-        rl.ClearBackground(g.background)
-
-        # NOTE: after updates, the nodes may be changed (enabled/disabled)
-        all_nodes.clear()
-        g.root.apply_enabled(all_nodes__append)
-
-        # render scene (sort by z-index via stable sort)
-        all_nodes.sort(key=node_sort_key)
-        fast_apply(Node._render, all_nodes)
-
-        # render gizmos
-        # enum
-        # {
-        # 	e_shapeBit				= 0x0001,	///< draw shapes
-        # 	e_jointBit				= 0x0002,	///< draw joint connections
-        # 	e_aabbBit				= 0x0004,	///< draw axis aligned bounding boxes
-        # 	e_pairBit				= 0x0008,	///< draw broad-phase pairs
-        # 	e_centerOfMassBit		= 0x0010	///< draw center of mass frame
-        # };
-        if g.debug_draw_box2d:
-            g.b2_world.debug_draw(0x0001 | 0x0002 | 0x0008 | 0x0010)
+        with profiler.scope('render'):
+            # recompute dirty world transforms in one pass
+            g.scene_graph.update_transforms()
+            # update world_to_viewport
+            self.PIXEL_UNIT_TRANSFORM.matmul(g.world_to_camera, out=g.world_to_viewport)
+
+            if g.default_lightmap:
+                g.default_lightmap.update()
+
+            rl.BeginDrawing()
+            rl.BeginMode2D(g.rl_camera_2d)
+            rl.ClearBackground(g.background)
+
+            # NOTE: after updates, the nodes may be changed (enabled/disabled)
+            # render scene (sorted by total z-index via stable sort, cached if nothing moved)
+            render_nodes = scene_graph.render_queue(g.root._tid)
+            deferred = self.deferred_rendering
+            if deferred:
+                g.sprite_batch.begin_deferred(scene_graph)
+            fast_apply_overridden(Node._render, Node, 'on_render', render_nodes)
+            if deferred:
+                # draw the recorded sprites in one pass
+                g.sprite_batch.end_deferred()
+            else:
+                # sprites leave their material bound for the next sprite
+                g.sprite_batch.release_shader()
+
+            # render gizmos
+            # enum
+            # {
+            # 	e_shapeBit				= 0x0001,	///< draw shapes
+            # 	e_jointBit				= 0x0002,	///< draw joint connections
+            # 	e_aabbBit				= 0x0004,	///< draw axis aligned bounding boxes
+            # 	e_pairBit				= 0x0008,	///< draw broad-phase pairs
+            # 	e_centerOfMassBit		= 0x0010	///< draw center of mass frame
+            # };
+            if g.debug_draw_box2d:
+                g.b2_world.debug_draw(0x0001 | 0x0002 | 0x0008 | 0x0010)
 
         # 5. render ui
-        g.is_rendering_ui = True
-        fast_apply(Node._render_ui, all_nodes)
-        g.is_rendering_ui = False
+        with profiler.scope('render_ui'):
+            g.is_rendering_ui = True
+            # nodes of cached containers are drawn by their container only if something changed
+            _update_ui_layers()
+            fast_apply_overridden(Node._render_ui, Node, 'on_render_ui', render_nodes)
+            g.sprite_batch.release_shader()
+            g.is_rendering_ui = False
 
         g.debug_window.render_selected_box()
         rl.EndMode2D()
@@ -176,15 +225,21 @@ class Game:
         rl.DrawFPS(rl.GetScreenWidth()-100, 0)
 
         # 6. submit
-        imgui.NewFrame()
-        g.debug_window.variables['mouse_pos'] = get_mouse_position()
-        g.debug_window.variables['gesture'] = rl.Gesture_NAMES[rl.GetGestureDetected()]
-        g.debug_window.variables['hovered_control'] = g.hovered_control
-        g.debug_window.variables['managed_sounds'] = _count_managed_sounds()
-        g.debug_window.variables['world_to_viewport'] = g.world_to_viewport
-        g.debug_window.render()
-        imgui.Render()
-        rl.EndDrawing()
+        with profiler.scope('imgui'):
+            imgui.NewFrame()
+            g.debug_window.variables['mouse_pos'] = get_mouse_position()
+            g.debug_window.variables['gesture'] = rl.Gesture_NAMES[rl.GetGestureDetected()]
+            g.debug_window.variables['hovered_control'] = g.hovered_control
+            g.debug_window.variables['managed_sounds'] = _count_managed_sounds()
+            g.debug_window.variables['sprites'] = g.sprite_batch.sprite_count
+            g.debug_window.variables['shader_switches'] = g.sprite_batch.shader_switches
+            g.debug_window.variables['draw_runs'] = g.sprite_batch.draw_runs
+            g.debug_window.variables['world_to_viewport'] = g.world_to_viewport
+            g.debug_window.render()
+            imgui.Render()
+        # includes waiting for vsync
+        with profiler.scope('present'):
+            rl.EndDrawing()
 
         # hot reload feature
         if rl.IsKeyPressed(rl.KEY_F5):
@@ -4,7 +4,8 @@ import raylib as rl
 from typing import Callable
 from __builtins import next
 
-from ._node import Node
+from ._node import Node, WaitForSeconds
+from . import g as _g
 
 class Tween:
     Ready = 0
@@ -12,6 +13,7 @@ class Tween:
     Completed = 2
 
     completed: Callable = None
+    _node: Node = None
 
     def __init__(self):
         self._state = Tween.Ready
@@ -34,7 +36,14 @@ class Tween:
             raise ValueError("a Tween instance can only be setup once")
         self._state = Tween.Playing
 
+    def _time(self) -> float:
+        # the playing node's scaled time
+        if self._node is None:
+            return rl.GetTime()
+        return _g.scheduler.time(self._node._tid)
+
     def play(self, node: Node):
+        self._node = node
         self._setup()
         node.start_coroutine(self)
 
@@ -50,15 +59,17 @@ class _Delayer(Tween):
 
     def _setup(self):
         super(_Delayer, self)._setup()
-        self._start_time = rl.GetTime()
+        self._parked = False
 
     def __next__(self):
-        t = rl.GetTime() - self._start_time
-        if t >= self.duration:
-            self._state = Tween.Completed
-            if self.completed is not None:
-                self.completed()
-            return StopIteration
+        # sleep in the scheduler instead of polling every frame
+        if not self._parked and self.duration > 0:
+            self._parked = True
+            return WaitForSeconds(self.duration)
+        self._state = Tween.Completed
+        if self.completed is not None:
+            self.completed()
+        return StopIteration
 
 
 class Tweener(Tween):
@@ -73,11 +84,11 @@ class Tweener(Tween):
     
     def _setup(self):
         super(Tweener, self)._setup()
-        self._start_time = rl.GetTime()
+        self._start_time = self._time()
         self._start_val = getattr(self.obj, self.name)
 
     def __next__(self):
-        t = rl.GetTime() - self._start_time
+        t = self._time() - self._start_time
         if t >= self.duration:
             setattr(self.obj, self.name, self.target)
             self._state = Tween.Completed
@@ -107,6 +118,8 @@ class TweenList(Tween):
         super(TweenList, self)._setup()
         self._i = 0
         assert len(self.items) > 0
+        for item in self.items:
+            item._node = self._node
         self.items[0]._setup()
 
     def __len__(self):
@@ -117,8 +130,10 @@ class TweenList(Tween):
 
     def __next__(self):
         tween = self.items[self._i]
-        if next(tween) is not StopIteration:
-            return
+        ret = next(tween)
+        if ret is not StopIteration:
+            # pass wait objects through to the scheduler
+            return ret if isinstance(ret, WaitForSeconds) else None
         self._i += 1
         if self._i >= len(self.items):
             self._state = Tween.Completed
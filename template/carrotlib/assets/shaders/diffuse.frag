@@ -6,15 +6,43 @@ _IN_ vec4 screenPos;
 // Input uniform values
 uniform sampler2D texture0;
 uniform sampler2D texture1;     // lightmap texture
+uniform vec2 lightmapSize;      // in texels
+uniform vec2 lightmapScale;     // viewport size / (lightmap size * divisor)
+uniform float lightmapRGBMRange;    // 0 for float texels
 uniform vec4 colDiffuse;        // tint color
 
 _DEFINE_GL_FRAG_COLOR_
 
+vec4 DecodeLightmap(vec4 texel)
+{
+    // RGBM does not store the alpha
+    if (lightmapRGBMRange > 0.0) return vec4(texel.rgb * (texel.a * lightmapRGBMRange), 1.0);
+    return texel;
+}
+
+// bilinear by hand, float textures are not filterable on every GPU
+// RGBM texels are decoded before they are interpolated
+vec4 SampleLightmap(vec2 screenCoord)
+{
+    // the lightmap is aligned to the top-left corner of the viewport
+    vec2 uv = vec2(screenCoord.x * lightmapScale.x, 1.0 - (1.0 - screenCoord.y) * lightmapScale.y);
+    vec2 st = uv * lightmapSize - 0.5;
+    vec2 i = floor(st);
+    vec2 f = st - i;
+    vec2 texelSize = 1.0 / lightmapSize;
+    vec2 p = (i + 0.5) * texelSize;
+    vec4 a = DecodeLightmap(texture(texture1, p));
+    vec4 b = DecodeLightmap(texture(texture1, p + vec2(texelSize.x, 0.0)));
+    vec4 c = DecodeLightmap(texture(texture1, p + vec2(0.0, texelSize.y)));
+    vec4 d = DecodeLightmap(texture(texture1, p + texelSize));
+    return mix(mix(a, b, f.x), mix(c, d, f.x), f.y);
+}
+
 void main()
 {
     vec2 screenCoord = screenPos.xy / screenPos.w;
     vec4 texel = texture(texture0, fragTexCoord);   // Get texel color
-    vec4 light = texture(texture1, screenCoord);    // Get light color
+    vec4 light = SampleLightmap(screenCoord);       // Get light color
     texel.xyz = sRGBToLinear(texel.xyz);
     vec4 finalColor = texel * colDiffuse * fragColor * light;
     finalColor.xyz = LinearToSRGB(finalColor.xyz);
@@ -0,0 +1,19 @@
+// Input vertex attributes (from vertex shader)
+_IN_ vec2 fragTexCoord;
+_IN_ vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;
+uniform vec4 colDiffuse;        // tint color
+uniform float smoothing;        // half width of the anti-aliased edge, set per text
+
+_DEFINE_GL_FRAG_COLOR_
+
+void main()
+{
+    // alpha is the distance to the glyph edge, 0.5 on the edge
+    float distance = texture(texture0, fragTexCoord).a;
+    vec4 finalColor = colDiffuse * fragColor;
+    finalColor.a *= smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+    _GL_FRAG_COLOR_ = finalColor;
+}
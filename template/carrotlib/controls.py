@@ -2,15 +2,21 @@ import raylib as rl
 from linalg import vec2
 from typing import Literal
 
-from _carrotlib import _rlDrawTextBoxed
+from _carrotlib import _rlDrawTextBoxed, prepare_text, _begin_ui_layer, _end_ui_layer, _draw_ui_layer
 
 from ._node import Node
 from ._colors import Colors
 from ._font import SpriteFont
-from ._renderer import draw_text, draw_rect, Texture2D, SubTexture2D
+from ._renderer import draw_text, draw_rect, Texture2D, SubTexture2D, _begin_text
 
 from . import g as _g
 
+def _color_key(color: rl.Color | None):
+    # colors are often modified in place, so compare their components
+    if color is None:
+        return None
+    return (color.r, color.g, color.b, color.a)
+
 def _convert_coordinates(old_pivot: vec2, new_pivot: vec2, position: vec2, width: float, height: float):
     # 计算旧锚点到新锚点的偏移量
     offset_x = (new_pivot.x - old_pivot.x) * width
@@ -129,6 +135,13 @@ class Control(Node):
     def is_hovering(self) -> bool:
         """Check if the mouse is hovering over the control."""
         return _g.hovered_control is self
+
+    def render_key(self) -> tuple:
+        """Return the values that decide how the control looks.
+        A cached `Container` renders its layer again when the key of any control in it changes.
+        Derived classes with their own visual fields should extend it.
+        """
+        return (self.is_hovering(),)
     
     def is_pressed(self) -> bool:
         """Check if the control is pressed."""
@@ -180,6 +193,9 @@ class Image(Control):
             dest_width * self.hfill_amount,
             dest_height * self.vfill_amount,
         )
+
+    def render_key(self) -> tuple:
+        return super().render_key() + (id(self.texture), _color_key(self.color), self.origin.x, self.origin.y, self.hfill_amount, self.vfill_amount)
     
     def on_render_ui(self):
         if self.texture is None:
@@ -223,6 +239,9 @@ class TextBase(Control):
         self.font_size = _g.default_font_size
         self.color = Colors.White.copy()
 
+    def render_key(self) -> tuple:
+        return super().render_key() + (self.text, id(self.font), self.font_size, self.spacing, self.line_spacing, _color_key(self.color))
+
 class Text(TextBase):
     """A text box for rendering long text with word wrap."""
 
@@ -231,6 +250,9 @@ class Text(TextBase):
         self.max_width = None
         self.max_height = None
 
+    def render_key(self) -> tuple:
+        return super().render_key() + (self.max_width, self.max_height)
+
     def __f(self, render: bool):
         assert self.font is not None
         assert self.max_width is not None
@@ -253,7 +275,10 @@ class Text(TextBase):
     def on_render_ui(self):
         if self.font is None:
             return
+        sdf = _begin_text(self.font, self.font_size)
         self.__f(True)
+        if sdf:
+            _g.sprite_batch.reset_shader()
 
 
 class Label(TextBase):
@@ -262,9 +287,13 @@ class Label(TextBase):
         super().__init__(name, parent)
         self.origin = vec2(0.5, 0.5)
 
+    def render_key(self) -> tuple:
+        return super().render_key() + (self.origin.x, self.origin.y)
+
     def global_rect(self) -> rl.Rectangle:
         if self.font is None:
             return rl.Rectangle(0, 0, 0, 0)
+        prepare_text(self.font, self.text)
         rl.SetTextLineSpacing(self.line_spacing + self.font_size)
         size = rl.MeasureTextEx(self.font, self.text, self.font_size, self.spacing)
         pos = self.global_position
@@ -299,12 +328,123 @@ class SpriteText(Control):
         self.font = None
         self.text = ""
         self.spacing = 0
+        self.line_spacing = 0
         self.color = Colors.White
+        self.origin = vec2(0.5, 0.5)
+        self.align = 0.5
+
+    def render_key(self) -> tuple:
+        return super().render_key() + (self.text, id(self.font), self.spacing, self.line_spacing, _color_key(self.color), self.origin.x, self.origin.y, self.align)
+
+    def global_rect(self) -> rl.Rectangle:
+        if self.font is None:
+            return rl.Rectangle(0, 0, 0, 0)
+        trans = self.transform()
+        pos = trans._t()
+        scale = trans._s()
+        size = self.font.measure(self.text, self.spacing, self.line_spacing)
+        size = vec2(size.x * scale.x, size.y * scale.y)
+        return rl.Rectangle(
+            pos.x - size.x * self.origin.x,
+            pos.y - size.y * self.origin.y,
+            size.x,
+            size.y,
+        )
 
     def on_render_ui(self):
         if self.font is None:
             return
-        self.font.draw(self.transform(), self.text, self.spacing, self.color)
+        self.font.draw(self.transform(), self.text, self.spacing, self.color, self.origin, self.align, self.line_spacing)
+
+class _UILayer:
+    """The render texture of a cached `Container` and the nodes drawn into it."""
+    def __init__(self, container: 'Container') -> None:
+        self.container = container
+        self.target: rl.RenderTexture2D = None
+        self.members: list[Node] = []
+        self.key = None
+        self.dirty = True
+        self.rendering = False
+
+    def update(self):
+        """Collect the nodes of the layer and check if any of them has changed.
+
+        It is called before the ui pass, so the nodes are skipped by it.
+        """
+        container = self.container
+        if container._state != 1 or container._ui_layer is not None:
+            # nested cached containers are drawn into the outermost layer
+            self._set_members([])
+            return
+        members, versions = _g.scene_graph.render_subtree(container._tid)
+        # moving any node changes `versions`
+        key = [versions, container.render_key()]
+        for node in members:
+            if isinstance(node, Control):
+                key.append((node._tid, node.render_key()))
+            else:
+                key.append(node._tid)
+        if members != self.members:
+            self._set_members(members)
+        if key != self.key:
+            self.key = key
+            self.dirty = True
+
+    def _set_members(self, members: list[Node]):
+        for node in self.members:
+            if node._ui_layer is self.container:
+                node._ui_layer = None
+        for node in members:
+            node._ui_layer = self.container
+        self.members = members
+        self.dirty = True
+
+    def draw(self):
+        rect = self.container.global_rect()
+        if self.dirty:
+            self._render(rect)
+        if self.target is not None:
+            _draw_ui_layer(self.target, rect)
+
+    def _render(self, rect: rl.Rectangle):
+        # one texel per screen pixel
+        zoom = _g.rl_camera_2d.zoom
+        width = int(rect.width * zoom + 0.5)
+        height = int(rect.height * zoom + 0.5)
+        if width <= 0 or height <= 0:
+            return
+        if self.target is None or self.target.texture.width != width or self.target.texture.height != height:
+            self._unload()
+            self.target = rl.LoadRenderTexture(width, height)
+
+        self.rendering = True
+        _g.sprite_batch.release_shader()
+        _begin_ui_layer(self.target, rect.x, rect.y, zoom)
+        self.container.on_render_ui()
+        for node in self.members:
+            if node._state == 1:
+                node.on_render_ui()
+        _g.sprite_batch.release_shader()
+        _end_ui_layer(_g.rl_camera_2d)
+        self.rendering = False
+        self.dirty = False
+
+    def _unload(self):
+        if self.target is not None:
+            rl.UnloadRenderTexture(self.target)
+            self.target = None
+
+    def destroy(self):
+        self._set_members([])
+        self._unload()
+        _ui_layers.remove(self)
+
+_ui_layers: list[_UILayer] = []
+
+def _update_ui_layers():
+    for layer in _ui_layers:
+        layer.update()
+
 
 class Container(Control):
     width: float
@@ -318,6 +458,38 @@ class Container(Control):
         self.height = _g.viewport_height
         self.origin = vec2(0.5, 0.5)
         self.color = None
+        self._layer: _UILayer = None
+
+    @property
+    def cached(self) -> bool:
+        """Render the container and its subtree into a render texture, which is drawn as one quad.
+
+        The texture is rendered again only when a node in the subtree is moved, added or removed,
+        or the `render_key()` of a control in it changes. Call `invalidate()` for other changes.
+        Nothing outside of `global_rect()` is drawn.
+        """
+        return self._layer is not None
+
+    @cached.setter
+    def cached(self, value: bool):
+        if value == self.cached:
+            return
+        if value:
+            self._layer = _UILayer(self)
+            self._raii_objects.append(self._layer)
+            _ui_layers.append(self._layer)
+        else:
+            self._layer.destroy()
+            self._raii_objects.remove(self._layer)
+            self._layer = None
+
+    def invalidate(self):
+        """Render the cached subtree again in the next frame."""
+        if self._layer is not None:
+            self._layer.dirty = True
+
+    def render_key(self) -> tuple:
+        return super().render_key() + (self.width, self.height, self.origin.x, self.origin.y, _color_key(self.color))
 
     def global_rect(self) -> rl.Rectangle:
         trans = self.transform()
@@ -340,5 +512,9 @@ class Container(Control):
         return inner
 
     def on_render_ui(self):
+        layer = self._layer
+        if layer is not None and not layer.rendering and self._ui_layer is None:
+            layer.draw()
+            return
         if self.color is not None:
             draw_rect(self.global_rect(), self.color)
@@ -142,8 +142,9 @@ class DebugWindow:
             if imgui.IsMouseDoubleClicked(0):
                 root.enabled = not root.enabled
 
-        if root.enabled and len(root._coroutines) > 0:
-            self.render_tree_colored_tag(f"({len(root._coroutines)})", vec4(1, 0.5, 0, 1))
+        coroutine_count = root.coroutine_count()
+        if root.enabled and coroutine_count > 0:
+            self.render_tree_colored_tag(f"({coroutine_count})", vec4(1, 0.5, 0, 1))
 
         if root.tags:
             self.render_tree_colored_tag(f"[{','.join(root.tags)}]", vec4(0.1, 0.6, 1, 1))
@@ -208,6 +209,31 @@ class DebugWindow:
             elif isinstance(selected, Sprite):
                 draw_rect(selected.global_rect(), color, solid=False)
 
+    def render_profiler(self):
+        profiler = g.profiler
+        profiler.render_graph(120)
+        # record frames into a chrome trace, open it in https://ui.perfetto.dev
+        if profiler.is_tracing():
+            imgui.TextDisabled("Capturing trace...")
+        elif imgui.Button("Capture 120 frames"):
+            profiler.start_trace(120)
+        path = profiler.last_trace_path()
+        if path is not None:
+            imgui.TextWrapped(f"Last trace: {path}")
+        imgui.Separator()
+        # p50/p95/p99 in milliseconds of the last frames
+        columns = (0, 140, 210, 280)
+        for i, title in enumerate(('phase (ms)', 'p50', 'p95', 'p99')):
+            if i > 0:
+                imgui.SameLine(columns[i])
+            imgui.TextDisabled(title)
+        for name in [None] + profiler.phases():
+            values = profiler.percentiles(name)
+            imgui.Text(name or 'frame')
+            for i in range(3):
+                imgui.SameLine(columns[i+1])
+                imgui.Text(f'{values[i]:.2f}')
+
     def render(self):
         imgui.SetNextWindowSize(vec2(self.w, self.h), imgui.ImGuiCond_FirstUseEver)
         imgui.SetNextWindowPos(vec2(0, 0), imgui.ImGuiCond_FirstUseEver)
@@ -256,5 +282,9 @@ class DebugWindow:
                     self.render_inspector(self.selected)
                 imgui.EndTabItem()
 
+            if imgui.BeginTabItem("Profiler"):
+                self.render_profiler()
+                imgui.EndTabItem()
+
             imgui.EndTabBar()
         imgui.End()
@@ -10,7 +10,12 @@ if TYPE_CHECKING:
     from .debug import DebugWindow
     from ._material import Material
     from ._light import Lightmap
+    from _carrotlib import SceneGraph, Scheduler, Profiler, SpriteBatch
 
+scene_graph: SceneGraph = None
+scheduler: Scheduler = None
+profiler: Profiler = None
+sprite_batch: SpriteBatch = None
 root: Node = None
 b2_world: World = None
 
@@ -43,6 +48,7 @@ PIXEL_PER_UNIT = 10
 default_font: rl.Font = None
 default_font_size: int = None
 default_material: Material = None
+sdf_text_material: Material = None
 default_lightmap: Lightmap = None
 default_text_spacing: float = 1.0
 default_text_line_spacing: int = 0
@@ -3,7 +3,7 @@ from linalg import vec2
 
 from .._node import Node
 from .. import g as _g
-from .._renderer import draw_texture, Texture2D, SubTexture2D
+from .._renderer import Texture2D, SubTexture2D
 from .._colors import Colors
 
 class Sprite(Node):
@@ -52,13 +52,16 @@ class Sprite(Node):
         else:
             raise ValueError(f'Unknown texture type: {type(self.texture)}')
 
-        with self.material:
-            draw_texture(
-                self.transform(),
-                main_tex,
-                src_rect,
-                self.flip_x,
-                self.flip_y,
-                self.color,
-                self.origin
-            )
+        # the material stays bound, so a run of sprites sharing it is one batch
+        self.material._bind()
+        _g.sprite_batch.draw(
+            self.transform(),
+            main_tex,
+            src_rect,
+            self.flip_x,
+            self.flip_y,
+            self.color,
+            self.origin,
+            False,
+            self._tid
+        )
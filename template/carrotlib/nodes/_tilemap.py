@@ -3,10 +3,10 @@ from collections import defaultdict
 from linalg import *
 import raylib as rl
 
-from ..ldtk.layer import AutoTiledLayer
+from _carrotlib import TilemapMesh
+from ..ldtk.layer import AutoTiledLayer, TileInfo
 
 from .._node import Node
-from .._colors import Colors
 
 from .. import g as _g
 
@@ -168,6 +168,9 @@ class Tilemap(Node):
     shader: rl.Shader
     b2_bodies: list[box2d.Body]
 
+    # cells per side of a render chunk
+    chunk_size = 32
+
     def __init__(self, layer: AutoTiledLayer, name=None, parent=None):
         self.layer = layer
         self.data = layer.intGridCsv
@@ -184,6 +187,11 @@ class Tilemap(Node):
         self.tex = rl.LoadTexture("assets/" + self.layer.get_tileset_def().relPath)
         self.material = _g.default_material
 
+        # tiles are baked once into chunks, only visible chunks are drawn
+        self.mesh = TilemapMesh(self.width, self.height, self.grid_size, self.chunk_size)
+        for x, y, info in self.tiles:
+            self.mesh.add(x, y + self.render_offset_y, info.srcX, info.srcY, info.flips, self.tex)
+
     def on_destroy(self):
         rl.UnloadTexture(self.tex)
     
@@ -210,38 +218,22 @@ class Tilemap(Node):
         pos = vec2(cx+0.5, cy+0.5) * self.cell_size
         return transform.transform_point(pos)
 
+    def set_cell_tiles(self, cx: int, cy: int, infos: list[TileInfo]):
+        """Replace the tiles drawn at a cell, only its chunk is rebuilt."""
+        self.tiles = [t for t in self.tiles if t[0] != cx or t[1] != cy]
+        cy_render = cy + self.render_offset_y
+        self.mesh.clear_cell(cx, cy_render)
+        for info in infos:
+            self.tiles.append((cx, cy, info))
+            self.mesh.add(cx, cy_render, info.srcX, info.srcY, info.flips, self.tex)
+
     def on_render(self):
         with self.material:
             self.draw(self.transform())
 
-    def draw(self, transform: mat3x3):
-        w2v = _g.world_to_viewport
-        scale = (w2v @ transform)._s() / _g.PIXEL_PER_UNIT
-
-        bound_x_min = -_g.viewport_width * 0.5
-        bound_x_max = _g.viewport_width * 1.5
-        bound_y_min = -_g.viewport_height * 0.5
-        bound_y_max = _g.viewport_height * 1.5
-
-        for x, y, info in self.tiles:
-            y += self.render_offset_y
-            pos = vec2(x, y) * self.cell_size
-            # optimized draw_sprite
-            pos = w2v.transform_point(transform.transform_point(pos))
-
-            # if pos is far away from the screen, skip it
-            if pos.x<bound_x_min or pos.x>bound_x_max or pos.y<bound_y_min or pos.y>bound_y_max:
-                continue
-
-            src_rect = rl.Rectangle(info.srcX, info.srcY, self.grid_size, self.grid_size)
-            dest_width = src_rect.width * scale.x
-            dest_height = src_rect.height * scale.y
-            if info.flips & 0b01:   # flip_x
-                src_rect.width *= -1
-            if info.flips & 0b10:   # flip_y
-                src_rect.height *= -1
-            dest_rect = rl.Rectangle(pos.x, pos.y, dest_width, dest_height)
-            rl.DrawTexturePro(self.tex, src_rect, dest_rect, vec2(0, 0), 0, Colors.White)
+    def draw(self, transform: mat3x3) -> int:
+        """Draw the chunks that intersect the viewport, return the number of drawn chunks."""
+        return self.mesh.draw(_g.sprite_batch, transform, self.tex, _g.viewport_width, _g.viewport_height)
 
     def bake_box2d_bodies(self, node: Node, optimize=True) -> list[box2d.Body]:
         bodies = []
@@ -5,9 +5,10 @@ from random import random, randint
 from typing import Literal, Callable
 
 from .._node import Node
-from .._renderer import draw_texture, Texture2D, SubTexture2D
+from .._renderer import Texture2D, SubTexture2D
 from .._colors import Colors
 from .._math import clamp01
+from .. import g as _g
 
 __all__ = ['Particles', 'EmissionShape', 'PointEmissionShape', 'CircleEmissionShape', 'RectEmissionShape', 'EdgeEmissionShape']
 
@@ -176,12 +177,17 @@ class Particles(Node):
             self.play()
 
     def on_render(self):
+        batch = _g.sprite_batch
+        # particles have no material, draw them with the default shader
+        batch.release_shader()
         t = mat3x3.identity()
+        tid = self._tid
         for p in self._particles:
+            if p.texture is None:
+                continue
             t.copy_trs_(p.position, p.rotation, p.scale)
             p._init_t.matmul(t, out=t)
-            if p.texture is not None:
-                draw_texture(t, p.texture, color=p.color)
+            batch.draw(t, p.texture, None, False, False, p.color, None, False, tid)
 
     def on_update(self):
         # on_update always precedes coroutines